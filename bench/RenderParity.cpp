@@ -0,0 +1,179 @@
+/**
+ * Headless check that banded parallel blending renders exactly what the
+ * single-threaded renderer does, plus frame times for both and the
+ * per-band timing of the parallel renderer.
+ *
+ * Two in-memory displays render the same scene (gradients, translucent
+ * overlays, rounded and bordered boxes, text, arcs), one with a
+ * ParallelRenderer attached. The frames are compared pixel for pixel and
+ * the process exits non-zero on any difference.
+ */
+
+#include "lvgl.h"
+#include "ParallelRenderer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr lv_coord_t kScreenWidth = 800;
+	constexpr lv_coord_t kScreenHeight = 480;
+	constexpr size_t kBands = 4;
+	constexpr int kFrames = 50;
+
+	struct MemoryDisplay
+	{
+		std::unique_ptr<lv_color_t[]>	buffer;
+		std::vector<lv_color_t>			frame;
+		lv_disp_draw_buf_t				drawBuf;
+		lv_disp_drv_t					drv;
+		lv_disp_t*						disp = nullptr;
+	};
+
+	void flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+	{
+		auto display = static_cast<MemoryDisplay*>(drv->user_data);
+		auto width = lv_area_get_width(area);
+
+		for (auto y = area->y1; y <= area->y2; ++y)
+		{
+			auto row = color_p + static_cast<size_t>(y - area->y1) * width;
+			memcpy(&display->frame[static_cast<size_t>(y) * kScreenWidth + area->x1], row, width * sizeof(lv_color_t));
+		}
+
+		lv_disp_flush_ready(drv);
+	}
+
+	void registerDisplay(MemoryDisplay& display, ParallelRenderer* renderer)
+	{
+		auto pixels = static_cast<uint32_t>(kScreenWidth) * kScreenHeight;
+
+		display.buffer = std::make_unique<lv_color_t[]>(pixels);
+		display.frame.resize(pixels);
+		lv_disp_draw_buf_init(&display.drawBuf, display.buffer.get(), nullptr, pixels);
+
+		lv_disp_drv_init(&display.drv);
+		display.drv.draw_buf = &display.drawBuf;
+		display.drv.flush_cb = &flushCb;
+		display.drv.hor_res = kScreenWidth;
+		display.drv.ver_res = kScreenHeight;
+		display.drv.user_data = &display;
+
+		if (renderer)
+			ParallelRenderer::prepare(&display.drv);
+
+		display.disp = lv_disp_drv_register(&display.drv);
+
+		if (renderer)
+			renderer->attach(display.disp);
+	}
+
+	void buildScene(lv_disp_t* disp)
+	{
+		auto screen = lv_disp_get_scr_act(disp);
+		lv_obj_set_style_bg_color(screen, lv_color_hex(0x202838), 0);
+		lv_obj_set_style_bg_grad_color(screen, lv_color_hex(0x6a3d1e), 0);
+		lv_obj_set_style_bg_grad_dir(screen, LV_GRAD_DIR_VER, 0);
+		lv_obj_set_style_bg_opa(screen, LV_OPA_COVER, 0);
+
+		for (int i = 0; i < 6; ++i)
+		{
+			auto box = lv_obj_create(screen);
+			lv_obj_set_size(box, 240, 140);
+			lv_obj_set_pos(box, 20 + (i % 3) * 260, 40 + (i / 3) * 200);
+			lv_obj_set_style_radius(box, 8 + i * 4, 0);
+			lv_obj_set_style_border_width(box, i + 1, 0);
+			lv_obj_set_style_bg_opa(box, LV_OPA_40 + i * 20, 0);
+			lv_obj_set_style_bg_color(box, lv_color_hex(0x3070c0 + i * 0x101010), 0);
+
+			auto label = lv_label_create(box);
+			lv_label_set_text_fmt(label, "%d.%d", 90 + i, i * 7 % 10);
+			lv_obj_set_style_text_font(label, &lv_font_montserrat_48, 0);
+			lv_obj_center(label);
+		}
+
+		auto arc = lv_arc_create(screen);
+		lv_obj_set_size(arc, 300, 300);
+		lv_obj_center(arc);
+		lv_arc_set_value(arc, 65);
+
+		// Translucent full-screen layer: the largest blend in the frame
+		auto overlay = lv_obj_create(screen);
+		lv_obj_set_size(overlay, kScreenWidth, kScreenHeight);
+		lv_obj_set_pos(overlay, 0, 0);
+		lv_obj_set_style_radius(overlay, 0, 0);
+		lv_obj_set_style_border_width(overlay, 0, 0);
+		lv_obj_set_style_bg_color(overlay, lv_color_hex(0x000000), 0);
+		lv_obj_set_style_bg_opa(overlay, LV_OPA_30, 0);
+	}
+
+	double renderFrames(MemoryDisplay& display)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < kFrames; ++i)
+		{
+			lv_obj_invalidate(lv_disp_get_scr_act(display.disp));
+			lv_refr_now(display.disp);
+		}
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kFrames;
+	}
+}
+
+int main()
+{
+	lv_init();
+
+	static MemoryDisplay serial;
+	static MemoryDisplay parallel;
+	ParallelRenderer renderer(kBands);
+
+	registerDisplay(serial, nullptr);
+	registerDisplay(parallel, &renderer);
+
+	buildScene(serial.disp);
+	buildScene(parallel.disp);
+
+	lv_refr_now(serial.disp);
+	lv_refr_now(parallel.disp);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < serial.frame.size(); ++i)
+	{
+		if (serial.frame[i].full != parallel.frame[i].full)
+			mismatches++;
+	}
+
+	renderer.resetStats();
+
+	auto serialMs = renderFrames(serial);
+	auto parallelMs = renderFrames(parallel);
+
+	printf("%dx%d, %zu bands\n", kScreenWidth, kScreenHeight, renderer.bands());
+	printf("  single-threaded  %7.3f ms/frame\n", serialMs);
+	printf("  parallel         %7.3f ms/frame (%.2fx)\n", parallelMs, serialMs / parallelMs);
+	printf("  %llu blends kept serial\n", static_cast<unsigned long long>(renderer.serialBlends()));
+
+	auto& stats = renderer.stats();
+	for (size_t band = 0; band < stats.size(); ++band)
+	{
+		auto& bandStats = stats[band];
+		printf("  band %zu: %llu blends, %llu px, %.3f ms total, %.3f ms max\n", band,
+			   static_cast<unsigned long long>(bandStats.blends), static_cast<unsigned long long>(bandStats.pixels),
+			   bandStats.totalMs, bandStats.maxMs);
+	}
+
+	if (mismatches)
+	{
+		printf("FAIL: %zu of %zu pixels differ\n", mismatches, serial.frame.size());
+		return 1;
+	}
+
+	printf("OK: frames are pixel-identical\n");
+	return 0;
+}
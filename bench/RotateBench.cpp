@@ -0,0 +1,115 @@
+/**
+ * Throughput of the 180° rotate-and-copy flush kernel against the scalar
+ * fallback, the previous two-pass path (rotate into a buffer, then copy
+ * each row to the framebuffer) and a plain copy, for a full-screen flush
+ * and typical small dirty areas.
+ */
+
+#include "Rotate180.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kScreenWidth = 800;
+	constexpr size_t kScreenHeight = 480;
+	constexpr auto kMinDuration = std::chrono::milliseconds(500);
+
+	struct Area
+	{
+		const char*	name;
+		size_t		width;
+		size_t		height;
+	};
+
+	using Kernel = void (*)(uint16_t* dst, const uint16_t* src, size_t width, size_t height, uint16_t* scratch);
+
+	void fused(uint16_t* dst, const uint16_t* src, size_t width, size_t height, uint16_t*)
+	{
+		rotate180Copy(dst, kScreenWidth, src, width, width, height);
+	}
+
+	void fusedScalar(uint16_t* dst, const uint16_t* src, size_t width, size_t height, uint16_t*)
+	{
+		for (size_t y = 0; y < height; ++y)
+			rotate180RowScalar(dst + (height - 1 - y) * kScreenWidth, src + y * width, width);
+	}
+
+	void twoPass(uint16_t* dst, const uint16_t* src, size_t width, size_t height, uint16_t* scratch)
+	{
+		auto pixels = width * height;
+
+		for (size_t i = 0; i < pixels; ++i)
+			scratch[i] = src[pixels - 1 - i];
+
+		for (size_t y = 0; y < height; ++y)
+			memcpy(dst + y * kScreenWidth, scratch + y * width, width * sizeof(uint16_t));
+	}
+
+	void copy(uint16_t* dst, const uint16_t* src, size_t width, size_t height, uint16_t*)
+	{
+		for (size_t y = 0; y < height; ++y)
+			memcpy(dst + y * kScreenWidth, src + y * width, width * sizeof(uint16_t));
+	}
+
+	double measure(Kernel kernel, const Area& area, uint16_t* framebuffer, const uint16_t* src, uint16_t* scratch)
+	{
+		size_t iterations = 0;
+		auto start = std::chrono::steady_clock::now();
+		auto elapsed = std::chrono::steady_clock::duration::zero();
+
+		while (elapsed < kMinDuration)
+		{
+			for (int i = 0; i < 64; ++i)
+				kernel(framebuffer, src, area.width, area.height, scratch);
+
+			iterations += 64;
+			elapsed = std::chrono::steady_clock::now() - start;
+		}
+
+		auto bytes = static_cast<double>(area.width * area.height * sizeof(uint16_t)) * iterations;
+
+		return bytes / std::chrono::duration<double>(elapsed).count() / 1e6;
+	}
+}
+
+int main(int, char**)
+{
+	const Area areas[] = {
+		{ "full screen 800x480", kScreenWidth, kScreenHeight },
+		{ "label 200x48", 200, 48 },
+		{ "icon 48x48", 48, 48 },
+		{ "digit 24x36", 24, 36 },
+	};
+
+	const struct
+	{
+		const char*	name;
+		Kernel		kernel;
+	} kernels[] = {
+		{ rotate180KernelName(), fused },
+		{ "scalar", fusedScalar },
+		{ "two-pass", twoPass },
+		{ "copy only", copy },
+	};
+
+	std::vector<uint16_t> framebuffer(kScreenWidth * kScreenHeight);
+	std::vector<uint16_t> src(kScreenWidth * kScreenHeight);
+	std::vector<uint16_t> scratch(kScreenWidth * kScreenHeight);
+
+	for (size_t i = 0; i < src.size(); ++i)
+		src[i] = static_cast<uint16_t>(i * 2654435761u);
+
+	for (auto& area : areas)
+	{
+		printf("%s\n", area.name);
+
+		for (auto& kernel : kernels)
+			printf("  %-10s %9.0f MB/s\n", kernel.name, measure(kernel.kernel, area, framebuffer.data(), src.data(), scratch.data()));
+	}
+
+	return 0;
+}
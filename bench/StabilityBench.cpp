@@ -0,0 +1,60 @@
+/**
+ * Feeds TemperatureStability with synthetic boiler samples at 1 kHz and
+ * reports the cost per sample for a range of window lengths.
+ */
+
+#include "TemperatureStability.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+	constexpr auto kSampleRate = 1000;
+	constexpr auto kDuration = std::chrono::minutes(10);
+}
+
+int main(int, char**)
+{
+	const std::chrono::seconds windows[] = {
+		std::chrono::seconds(10),
+		std::chrono::seconds(60),
+		std::chrono::seconds(300),
+	};
+
+	for (auto window : windows)
+	{
+		TemperatureStability stability(std::chrono::seconds(10), window, window.count() * kSampleRate + 1);
+
+		std::mt19937 rng(42);
+		std::normal_distribution<float> noise(0.0f, 0.05f);
+
+		const auto samples = static_cast<size_t>(std::chrono::duration_cast<std::chrono::seconds>(kDuration).count() * kSampleRate);
+		auto timestamp = std::chrono::steady_clock::time_point();
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < samples; ++i)
+		{
+			timestamp += std::chrono::microseconds(1000000 / kSampleRate);
+
+			// Heat-up towards 93 degC with a little overshoot, then noise
+			auto t = static_cast<float>(i) / kSampleRate;
+			auto temp = 93.0f - 70.0f * std::exp(-t / 30.0f) * std::cos(t / 40.0f) + noise(rng);
+
+			stability.onBoilerSample({ timestamp, temp, 93.0f, 0.0f, 0.0f, BoilerState::Heating });
+		}
+
+		auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		auto& stats = stability.stats();
+
+		printf("window %4llds: %8.1f ns/sample (%.0fx real time at 1 kHz), mean %.2f stddev %.3f slope %.4f overshoot %.2f stable %d\n",
+			   static_cast<long long>(window.count()),
+			   elapsed / samples,
+			   1e9 / (elapsed / samples) / kSampleRate,
+			   stats.mean, stats.stddev, stats.slope, stats.overshoot, stats.stable);
+	}
+
+	return 0;
+}
@@ -11,6 +11,8 @@
 
 #include <netdb.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "lvgl/lvgl.h"
@@ -18,10 +20,13 @@
 
 #include "EspressoUI.hpp"
 #include "EspressoConnectionScreen.hpp"
+#include "ShotRecorder.hpp"
+#include "TelemetryReplay.hpp"
 
 static void hal_init();
 static void timer_init();
 static std::string resolveURL(const char* hostname);
+static int runReplay(const char* path, float speed);
 
 namespace
 {
@@ -30,7 +35,7 @@ namespace
 	const auto kMinTicks = 0;//4800;
 }
 
-[[noreturn]]int main(int, char**)
+int main(int argc, char** argv)
 {
 	/*Initialize LVGL*/
 	lv_init();
@@ -39,6 +44,10 @@ namespace
 	auto& settings = SettingsManager::get();
 	settings.load();
 
+	// --replay <file> [speed]: play back a recorded session instead of polling
+	if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+		return runReplay(argv[2], argc > 3 ? atof(argv[3]) : 1.0f);
+
 	auto resolveFut = std::async(&resolveURL, kHostname);
 
 	std::unique_ptr<BoilerController>	boiler;
@@ -175,3 +184,42 @@ static std::string resolveURL(const char* hostname)
 
 	return "http://" + std::string(inet_ntoa(*(struct in_addr*)(hp->h_addr_list[0])));
 }
+
+static int runReplay(const char* path, float speed)
+{
+	auto rows = ShotRecorder::load(path);
+	if (rows.empty())
+	{
+		printf("Nothing to replay in %s\n", path);
+		return -1;
+	}
+
+	BoilerController boiler;
+	ScalesController scales;
+	EspressoUI ui;
+
+	ui.init(&boiler, &scales);
+
+	TelemetryReplay replay(std::move(rows), boiler, scales);
+	replay.setSpeed(speed);
+
+	printf("Replaying %s at %.1fx\n", path, speed);
+
+	while (! replay.finished())
+	{
+		replay.tick();
+
+		boiler.tick();
+		scales.tick();
+
+		auto renderStart = std::chrono::steady_clock::now();
+		lv_timer_handler();
+		replay.recordFrame(std::chrono::steady_clock::now() - renderStart);
+
+		usleep(500);
+	}
+
+	replay.printSummary();
+
+	return 0;
+}
@@ -3,28 +3,94 @@
 
 #include "nlohmann/json.hpp"
 
-BoilerController::BoilerController(const std::string& url)
-	: m_httpClient(url)
+#include <thread>
+
+namespace
 {
-	m_httpClient.set_keep_alive(true);
+	constexpr auto kTempDisplayStep = 0.1f;
+	constexpr auto kTempDisplayHysteresis = 0.02f;
+	constexpr auto kPressureDisplayStep = 0.1f;
+	constexpr auto kPressureDisplayHysteresis = 0.02f;
+
+	constexpr auto kDisplayRefreshPeriod = std::chrono::milliseconds(16);
+	constexpr auto kMaxExtrapolation = std::chrono::milliseconds(250);
+
+	// Poll cadence while no endpoint has a subscriber
+	constexpr auto kIdlePollDelay = std::chrono::milliseconds(100);
+
+	// Keeps a machine that dropped off the network from holding a poll thread for long
+	constexpr time_t kConnectTimeoutSec = 1;
+	constexpr time_t kReadTimeoutSec = 2;
+
+	// Consecutive failed polls before the machine counts as unreachable
+	constexpr uint32_t kMaxFailedPolls = 3;
+
+	// PID terms are read back at least this often, to catch a restart the other checks miss
+	constexpr auto kPIDVerifyInterval = std::chrono::seconds(10);
+
+	// Parsed body of a successful GET, or nothing if the machine didn't answer properly
+	std::optional<nlohmann::json> getJSON(httplib::Client& client, const char* path)
+	{
+		auto res = client.Get(path);
+		if (! res || res->status != 200)
+			return std::nullopt;
 
-	auto res = m_httpClient.Get("/api/v1/temp/raw");
-	auto tempJSON = nlohmann::json::parse(res->body);
+		auto json = nlohmann::json::parse(res->body, nullptr, false);
+		if (json.is_discarded())
+			return std::nullopt;
 
-	m_currentTemp = tempJSON["current"].get<float>();
-	m_targetTemp = tempJSON["target"].get<float>();
-	m_brewTarget = tempJSON["brew"].get<float>();
-	m_steamTarget = tempJSON["steam"].get<float>();
+		return json;
+	}
 
-	res = m_httpClient.Get("/api/v1/pressure/raw");
-	auto pressureJSON = nlohmann::json::parse(res->body);
+	bool postJSON(httplib::Client& client, const char* path, const nlohmann::json& body)
+	{
+		return static_cast<bool>(client.Post(path, body.dump(), "application/json"));
+	}
 
-	auto pressureCurrent = pressureJSON["current"].get<float>();
-	auto pressureTarget = pressureJSON["target"].get<float>();
-	m_brewTargetPressure = pressureJSON["brew"].get<float>();
+	// Device uptime in microseconds, reported by firmware that supports clock alignment
+	std::optional<int64_t> deviceTime(const nlohmann::json& json)
+	{
+		if (auto it = json.find("uptime_us"); it != json.end() && it->is_number_integer())
+			return it->get<int64_t>();
 
+		return std::nullopt;
+	}
+}
+
+BoilerController::BoilerController(const std::string& url, PollReactor* reactor, Mode mode)
+	: m_reactor(reactor)
+	, m_httpClient(url)
+	, m_commandClient(url)
+	, m_url(url)
+	, m_monitor(mode == Mode::Monitor)
+	, m_currentTempDisplay(kTempDisplayStep, kTempDisplayHysteresis)
+	, m_currentPressureDisplay(kPressureDisplayStep, kPressureDisplayHysteresis)
+	, m_currentTempModel(kMaxExtrapolation)
+	, m_currentPressureModel(kMaxExtrapolation)
+{
+	for (auto client : { &m_httpClient, &m_commandClient })
+	{
+		client->set_keep_alive(true);
+		client->set_connection_timeout(kConnectTimeoutSec, 0);
+		client->set_read_timeout(kReadTimeoutSec, 0);
+	}
+
+	// A monitor never takes the local settings, so it can't overwrite the machine's
+	if (! m_monitor)
+		bindSettings();
+
+	schedulePoll();
+}
+
+void BoilerController::bindSettings()
+{
 	auto& settings = SettingsManager::get();
 
+	// Local settings are authoritative; polls push any the machine doesn't have yet
+	m_brewTarget = settings["BrewTemp"].getAs<float>();
+	m_steamTarget = settings["SteamTemp"].getAs<float>();
+	m_brewTargetPressure = settings["BrewPressure"].getAs<float>();
+
 	settings["BrewTemp"].registerDelegate(this);
 	settings["SteamTemp"].registerDelegate(this);
 	settings["BrewPressure"].registerDelegate(this);
@@ -33,8 +99,6 @@ BoilerController::BoilerController(const std::string& url)
 	m_floatSettings.emplace("SteamTemp", m_steamTarget);
 	m_floatSettings.emplace("BrewPressure", m_brewTargetPressure);
 
-	nlohmann::json pidSetJSON;
-
 	m_boilerPID = {
 		settings["BoilerKp"].getAs<float>(),
 		settings["BoilerKi"].getAs<float>(),
@@ -47,11 +111,6 @@ BoilerController::BoilerController(const std::string& url)
 		settings["PumpKd"].getAs<float>(),
 	};
 
-	pidSetJSON["PumpPID"]   = { m_pumpPID.Kp, m_pumpPID.Ki, m_pumpPID.Kd };
-	pidSetJSON["BoilerPID"] = { m_boilerPID.Kp, m_boilerPID.Ki, m_boilerPID.Kd };
-
-	res = m_httpClient.Post("/api/v1/pid/terms", pidSetJSON.dump(), "application/json");
-
 	settings["BoilerKp"].registerDelegate(this);
 	settings["BoilerKi"].registerDelegate(this);
 	settings["BoilerKd"].registerDelegate(this);
@@ -68,8 +127,6 @@ BoilerController::BoilerController(const std::string& url)
 	m_floatSettings.emplace("PumpKi", m_pumpPID.Ki);
 	m_floatSettings.emplace("PumpKd", m_pumpPID.Kd);
 
-	res = m_httpClient.Post("/api/v1/boiler/clear-inhibit", "", "application/json");
-
 	settings["ManualPumpControl"].registerDelegate(this);
 	m_floatSettings.emplace("ManualPumpControl", m_pumpDuty);
 
@@ -78,18 +135,36 @@ BoilerController::BoilerController(const std::string& url)
 
 	settings["HotWaterModeEnabled"].registerDelegate(this);
 	m_boolSettings.emplace("HotWaterModeEnabled", m_hotWaterMode);
+}
 
-	m_pollFut = std::async(&BoilerController::pollRemoteServer, this);
+BoilerController::~BoilerController()
+{
+	// Reactor futures do not block on destruction, so wait for an in-flight poll here
+	if (m_pollFut.valid())
+		m_pollFut.wait();
 }
 
-void BoilerController::registerBoilerTemperatureDelegate(BoilerTemperatureDelegate* delegate)
+BoilerController::BoilerController()
+	: m_httpClient("")
+	, m_commandClient("")
+	, m_offline(true)
+	, m_currentTempDisplay(kTempDisplayStep, kTempDisplayHysteresis)
+	, m_currentPressureDisplay(kPressureDisplayStep, kPressureDisplayHysteresis)
+	, m_currentTempModel(kMaxExtrapolation)
+	, m_currentPressureModel(kMaxExtrapolation)
+{
+}
+
+void BoilerController::registerBoilerTemperatureDelegate(BoilerTemperatureDelegate* delegate, uint32_t endpoints)
 {
 	if (m_delegates.find(delegate) != m_delegates.end())
 		return;
 
 	m_delegates.emplace(delegate);
+	m_delegateEndpoints[delegate] = endpoints;
+	m_subscriptions.subscribe(endpoints);
 
-	delegate->onBoilerCurrentTempChanged(m_currentTemp);
+	delegate->onBoilerCurrentTempChanged(m_currentTempDisplay.value());
 	delegate->onBoilerTargetTempChanged(m_targetTemp);
 }
 
@@ -97,6 +172,66 @@ void BoilerController::deregisterBoilerTemperatureDelegate(BoilerTemperatureDele
 {
 	if (auto it = m_delegates.find(delegate); it != m_delegates.end())
 		m_delegates.erase(it);
+
+	if (auto it = m_delegateEndpoints.find(delegate); it != m_delegateEndpoints.end())
+	{
+		m_subscriptions.unsubscribe(it->second);
+		m_delegateEndpoints.erase(it);
+	}
+}
+
+void BoilerController::registerBoilerSampleDelegate(BoilerSampleDelegate* delegate)
+{
+	if (m_sampleDelegates.emplace(delegate).second)
+		m_subscriptions.subscribe(kSampleEndpoints);
+}
+
+void BoilerController::deregisterBoilerSampleDelegate(BoilerSampleDelegate* delegate)
+{
+	if (auto it = m_sampleDelegates.find(delegate); it != m_sampleDelegates.end())
+	{
+		m_sampleDelegates.erase(it);
+		m_subscriptions.unsubscribe(kSampleEndpoints);
+	}
+}
+
+void BoilerController::setRealtimeDelegate(BoilerRealtimeDelegate* delegate)
+{
+	// A poll in flight may already have loaded the previous delegate, so let it finish first
+	if (m_realtimeDelegate.load() && m_pollFut.valid())
+		m_pollFut.wait();
+
+	auto previous = m_realtimeDelegate.exchange(delegate);
+
+	if (delegate && ! previous)
+		m_subscriptions.subscribe(kSampleEndpoints);
+	else if (! delegate && previous)
+		m_subscriptions.unsubscribe(kSampleEndpoints);
+}
+
+void BoilerController::registerHealthDelegate(DeviceHealthSampleDelegate* delegate)
+{
+	if (m_healthDelegates.emplace(delegate).second)
+		m_subscriptions.subscribe(EndpointSysInfo);
+}
+
+void BoilerController::deregisterHealthDelegate(DeviceHealthSampleDelegate* delegate)
+{
+	if (auto it = m_healthDelegates.find(delegate); it != m_healthDelegates.end())
+	{
+		m_healthDelegates.erase(it);
+		m_subscriptions.unsubscribe(EndpointSysInfo);
+	}
+}
+
+void BoilerController::subscribe(uint32_t endpoints)
+{
+	m_subscriptions.subscribe(endpoints);
+}
+
+void BoilerController::unsubscribe(uint32_t endpoints)
+{
+	m_subscriptions.unsubscribe(endpoints);
 }
 
 void BoilerController::updateBoilerTargetTemp(float temp)
@@ -112,13 +247,18 @@ void BoilerController::updateBoilerTargetTemp(float temp)
 
 void BoilerController::updateBoilerCurrentTemp(float temp)
 {
-	if (m_currentTemp == temp)
-		return;
-
 	m_currentTemp = temp;
 
+	displayCurrentTemp(temp);
+}
+
+void BoilerController::displayCurrentTemp(float temp)
+{
+	if (! m_currentTempDisplay.update(temp))
+		return;
+
 	for (auto delegate : m_delegates)
-		delegate->onBoilerCurrentTempChanged(temp);
+		delegate->onBoilerCurrentTempChanged(m_currentTempDisplay.value());
 }
 
 void BoilerController::updateBoilerState(int state)
@@ -136,10 +276,13 @@ void BoilerController::updateBoilerState(int state)
 
 void BoilerController::updatePumpDuty(float duty)
 {
-	if (m_pumpDuty == duty)
+	if (m_reportedPumpDuty == duty)
 		return;
 
-	m_pumpDuty = duty;
+	m_reportedPumpDuty = duty;
+
+	for (auto delegate : m_delegates)
+		delegate->onBoilerPumpDutyChanged(duty);
 }
 
 void BoilerController::setBoilerBrewTemp(float temp)
@@ -147,12 +290,10 @@ void BoilerController::setBoilerBrewTemp(float temp)
 	if (m_brewTarget == temp)
 		return;
 
-	m_brewTarget = temp;
-
-	nlohmann::json tempSetJSON;
-	tempSetJSON["brewTarget"] = temp;
-
-	auto res = m_httpClient.Post("/api/v1/temp/raw", tempSetJSON.dump(), "application/json");
+	{
+		std::lock_guard lock(m_settingsMutex);
+		m_brewTarget = temp;
+	}
 
 	for (auto delegate : m_delegates)
 		delegate->onBoilerBrewTempChanged(temp);
@@ -163,26 +304,46 @@ void BoilerController::setBoilerBrewPressure(float pressure)
 	if (m_brewTargetPressure == pressure)
 		return;
 
-	m_brewTargetPressure = pressure;
-
-	nlohmann::json pressureJSON;
-	pressureJSON["brewTarget"] = pressure;
-
-	auto res = m_httpClient.Post("/api/v1/pressure/raw", pressureJSON.dump(), "application/json");
+	{
+		std::lock_guard lock(m_settingsMutex);
+		m_brewTargetPressure = pressure;
+	}
 
 //	for (auto delegate : m_delegates)
 //		delegate->onBoilerBrewTempChanged(temp);
 }
 
-void BoilerController::updateBoilerCurrentPressure(float pressure)
+void BoilerController::stopPump()
 {
-	if (m_brewCurrentPressure == pressure)
+	// Seen by the next poll, which keeps the pump off until the shot ends
+	m_pumpStopTime = std::chrono::steady_clock::now().time_since_epoch().count();
+
+	if (! canWrite())
 		return;
 
+	nlohmann::json pumpControlJSON;
+	pumpControlJSON["Duty"] = 0.0f;
+	pumpControlJSON["ManualControl"] = true;
+
+	// Only serializes stops on the command connection; the poll never takes this lock
+	std::lock_guard lock(m_commandMutex);
+	m_commandClient.Post("/api/v1/pump/manual-control", pumpControlJSON.dump(), "application/json");
+}
+
+void BoilerController::updateBoilerCurrentPressure(float pressure)
+{
 	m_brewCurrentPressure = pressure;
 
+	displayCurrentPressure(pressure);
+}
+
+void BoilerController::displayCurrentPressure(float pressure)
+{
+	if (! m_currentPressureDisplay.update(pressure))
+		return;
+
 	for (auto delegate : m_delegates)
-		delegate->onBoilerPressureChanged(pressure);
+		delegate->onBoilerPressureChanged(m_currentPressureDisplay.value());
 }
 
 void BoilerController::setBoilerSteamTemp(float temp)
@@ -190,12 +351,10 @@ void BoilerController::setBoilerSteamTemp(float temp)
 	if (m_steamTarget == temp)
 		return;
 
-	m_steamTarget = temp;
-
-	nlohmann::json tempSetJSON;
-	tempSetJSON["steamTarget"] = temp;
-
-	auto res = m_httpClient.Post("/api/v1/temp/raw", tempSetJSON.dump(), "application/json");
+	{
+		std::lock_guard lock(m_settingsMutex);
+		m_steamTarget = temp;
+	}
 
 	for (auto delegate : m_delegates)
 		delegate->onBoilerSteamTempChanged(temp);
@@ -203,133 +362,453 @@ void BoilerController::setBoilerSteamTemp(float temp)
 
 void BoilerController::tick()
 {
-	if (m_pollFut.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
+	auto now = m_clock->now();
+
+	if (m_pollFut.valid() && m_pollFut.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
 	{
 		auto val = m_pollFut.get();
-		updateBoilerCurrentTemp(val.currentTemp);
-		updateBoilerTargetTemp(val.targetTemp);
-		updateBoilerState(val.state);
 
-		updateBoilerCurrentPressure(val.currentPressure);
+		if (val.health)
+		{
+			for (auto delegate : m_healthDelegates)
+				delegate->onDeviceHealthSample(*val.health);
+		}
+
+		if (val.sampled)
+		{
+			processSample({
+				val.timestamp,
+				val.currentTemp,
+				val.targetTemp,
+				val.currentPressure,
+				val.pumpDuty,
+				static_cast<BoilerState>(val.state),
+			});
+		}
+
+		m_lastDisplayRefresh = now;
+
+		schedulePoll();
+	}
+	else if (now - m_lastDisplayRefresh >= kDisplayRefreshPeriod && m_currentTempModel.valid())
+	{
+		m_lastDisplayRefresh = now;
 
-		m_pollFut = std::async(std::launch::async, &BoilerController::pollRemoteServer, this);
+		displayCurrentTemp(m_currentTempModel.valueAt(now));
+		displayCurrentPressure(m_currentPressureModel.valueAt(now));
 	}
 }
 
+void BoilerController::injectSample(const BoilerSample& sample)
+{
+	if (auto delegate = m_realtimeDelegate.load())
+		delegate->onBoilerSampleRealtime(sample);
+
+	processSample(sample);
+
+	m_lastDisplayRefresh = m_clock->now();
+}
+
+void BoilerController::setClock(const TelemetryClock* clock)
+{
+	m_clock = clock ? clock : &TelemetryClock::steady();
+}
+
+void BoilerController::processSample(const BoilerSample& sample)
+{
+	for (auto delegate : m_sampleDelegates)
+		delegate->onBoilerSample(sample);
+
+	m_currentTempModel.addSample(sample.timestamp, sample.currentTemp);
+	m_currentPressureModel.addSample(sample.timestamp, sample.currentPressure);
+
+	updateBoilerCurrentTemp(sample.currentTemp);
+	updateBoilerTargetTemp(sample.targetTemp);
+	updateBoilerState(static_cast<int>(sample.state));
+
+	updateBoilerCurrentPressure(sample.currentPressure);
+	updatePumpDuty(sample.pumpDuty);
+}
+
 void BoilerController::onChanged(const std::string& key, float val)
 {
+	std::lock_guard lock(m_settingsMutex);
+
 	if (auto it = m_floatSettings.find(key); it != m_floatSettings.end())
 		it->second = val;
 }
 
 void BoilerController::onChanged(const std::string& key, bool val)
 {
+	std::lock_guard lock(m_settingsMutex);
+
 	if (auto it = m_boolSettings.find(key); it != m_boolSettings.end())
 		it->second = val;
 }
 
+void BoilerController::schedulePoll()
+{
+	auto idle = ! m_subscriptions.any();
+
+	// An idle back-off waits on the reactor's timer, not on a shared poll thread
+	if (m_reactor && idle)
+		m_pollFut = m_reactor->submitAfter(kIdlePollDelay, [this] { return pollRemoteServer(); });
+	else if (m_reactor)
+		m_pollFut = m_reactor->submit([this] { return pollRemoteServer(); });
+	else
+		m_pollFut = std::async(std::launch::async, [this, idle] {
+			if (idle)
+				std::this_thread::sleep_for(kIdlePollDelay);
+
+			return pollRemoteServer();
+		});
+}
+
 BoilerController::PollData BoilerController::pollRemoteServer()
 {
-	auto res = m_httpClient.Get("/api/v1/temp/raw");
-	auto tempJSON = nlohmann::json::parse(res->body);
-	auto boilerTemp = tempJSON["current"].get<float>();
-	auto targetTemp = tempJSON["target"].get<float>();
-	auto boilerState = tempJSON["state"].get<int>();
+	// Endpoints nobody subscribes to keep their last values
+	auto data = m_lastPoll;
+	data.sampled = false;
+	data.health.reset();
 
-	res = m_httpClient.Get("/api/v1/pressure/raw");
-	auto pressureJSON = nlohmann::json::parse(res->body);
-	auto pressureCurrent = pressureJSON["current"].get<float>();
-	auto pressureTarget = pressureJSON["target"].get<float>();
-	auto pressureBrewTarget = pressureJSON["brew"].get<float>();
-	auto pumpDuty = pressureJSON["manual-duty"].get<float>();
-	auto pumpManualMode = pressureJSON["manual-mode"].get<bool>();
-	auto hotWaterMode = pressureJSON["hot-water-mode"].get<bool>();
-	auto pumpState = pressureJSON["state"].get<int>();
+	// Settings are still pushed while nothing is read, so only a monitor has nothing to do
+	if (! m_subscriptions.any() && ! canWrite())
+		return data;
 
-	if (m_brewTarget != tempJSON["brew"].get<float>())
+	auto polled = data;
+	auto succeeded = false;
+
+	try
 	{
-		nlohmann::json brewTargetJSON;
-		brewTargetJSON["brewTarget"] = m_brewTarget;
+		succeeded = pollEndpoints(polled);
+	}
+	catch (const nlohmann::json::exception& e)
+	{
+		printf("BoilerController: Unexpected response from %s: %s\n", m_url.c_str(), e.what());
+	}
+
+	if (succeeded)
+	{
+		m_failedPolls = 0;
+		m_reachable = true;
+		m_lastPoll = polled;
 
-		res = m_httpClient.Post("/api/v1/temp/raw", brewTargetJSON.dump(), "application/json");
+		return polled;
 	}
 
-	if (m_steamTarget != tempJSON["steam"].get<float>())
+	// A partial poll is dropped as a whole, and the next one starts over
+	if (++m_failedPolls == kMaxFailedPolls)
 	{
-		nlohmann::json steamTargetJSON;
-		steamTargetJSON["steamTarget"] = m_steamTarget;
+		printf("BoilerController: %s stopped answering\n", m_url.c_str());
+
+		m_reachable = false;
+		m_connectionLost = true;
+
+		// It may have restarted meanwhile, with default terms, inhibited and its clock reset
+		m_handshakeDone = false;
+		m_clockSync.reset();
+	}
+
+	return data;
+}
 
-		res = m_httpClient.Post("/api/v1/temp/raw", steamTargetJSON.dump(), "application/json");
+bool BoilerController::pollEndpoints(PollData& data)
+{
+	if (m_handshakeDone && canWrite() && ! verifyPIDTerms())
+		return false;
+
+	if (! m_handshakeDone && canWrite())
+	{
+		// Once per connection: push the local PID terms and clear the start-up inhibit
+		PIDTerms pushedBoilerPID, pushedPumpPID;
+
+		{
+			std::lock_guard lock(m_settingsMutex);
+			pushedBoilerPID = m_boilerPID;
+			pushedPumpPID = m_pumpPID;
+		}
+
+		nlohmann::json pidSetJSON;
+		pidSetJSON["PumpPID"]   = { pushedPumpPID.Kp, pushedPumpPID.Ki, pushedPumpPID.Kd };
+		pidSetJSON["BoilerPID"] = { pushedBoilerPID.Kp, pushedBoilerPID.Ki, pushedBoilerPID.Kd };
+
+		if (! m_httpClient.Post("/api/v1/pid/terms", pidSetJSON.dump(), "application/json")
+			|| ! m_httpClient.Post("/api/v1/boiler/clear-inhibit", "", "application/json"))
+			return false;
+
+		m_pushedBoilerPID = pushedBoilerPID;
+		m_pushedPumpPID = pushedPumpPID;
+		m_pushed = {};
+		m_handshakeDone = true;
 	}
 
-	if (m_brewTargetPressure != pressureBrewTarget)
+	auto pollStart = std::chrono::steady_clock::now().time_since_epoch().count();
+
+	std::optional<nlohmann::json> tempJSON;
+	std::optional<nlohmann::json> pressureJSON;
+	ClockSync::Exchange exchange;
+
+	if (m_subscriptions.active(EndpointTemperature))
 	{
-		nlohmann::json brewTargetJSON;
-		brewTargetJSON["brewTarget"] = m_brewTargetPressure;
+		exchange.sent = std::chrono::steady_clock::now();
+		tempJSON = getJSON(m_httpClient, "/api/v1/temp/raw");
+		exchange.received = std::chrono::steady_clock::now();
+
+		if (! tempJSON)
+			return false;
 
-		res = m_httpClient.Post("/api/v1/pressure/raw", brewTargetJSON.dump(), "application/json");
+		data.currentTemp = (*tempJSON)["current"].get<float>();
+		data.targetTemp = (*tempJSON)["target"].get<float>();
+		data.state = (*tempJSON)["state"].get<int>();
+		exchange.deviceTimeUs = deviceTime(*tempJSON);
 	}
 
-	if (m_pumpDuty != pumpDuty || m_pumpManualMode != pumpManualMode)
+	// Pressure moves fastest, so when fetched the sample is placed at the pressure reading
+	if (m_subscriptions.active(EndpointPressure))
 	{
-		nlohmann::json pumpControlJSON;
-		pumpControlJSON["Duty"] = m_pumpDuty;
-		pumpControlJSON["ManualControl"] = m_pumpManualMode;
+		exchange.sent = std::chrono::steady_clock::now();
+		pressureJSON = getJSON(m_httpClient, "/api/v1/pressure/raw");
+		exchange.received = std::chrono::steady_clock::now();
+
+		if (! pressureJSON)
+			return false;
 
-		res = m_httpClient.Post("/api/v1/pump/manual-control", pumpControlJSON.dump(), "application/json");
+		data.currentPressure = (*pressureJSON)["current"].get<float>();
+		data.pumpDuty = (*pressureJSON)["manual-duty"].get<float>();
+		exchange.deviceTimeUs = deviceTime(*pressureJSON);
 	}
 
-	if (m_hotWaterMode != hotWaterMode)
+	if (tempJSON || pressureJSON)
 	{
-		nlohmann::json pumpControlJSON;
-		pumpControlJSON["HotWaterMode"] = m_hotWaterMode;
+		if (exchange.deviceTimeUs && m_lastDeviceTimeUs && *exchange.deviceTimeUs < *m_lastDeviceTimeUs)
+			deviceRestarted("uptime went backwards");
+
+		m_lastDeviceTimeUs = exchange.deviceTimeUs;
+
+		data.timestamp = m_clockSync.place(exchange);
+		data.sampled = true;
+
+		if (auto delegate = m_realtimeDelegate.load())
+			delegate->onBoilerSampleRealtime({ data.timestamp, data.currentTemp, data.targetTemp, data.currentPressure, data.pumpDuty, static_cast<BoilerState>(data.state) });
+	}
+
+	if (m_subscriptions.active(EndpointSysInfo))
+	{
+		auto sysinfoJSON = getJSON(m_httpClient, "/api/v1/sys/info");
+		if (! sysinfoJSON)
+			return false;
+
+		data.health = DeviceHealthSample {
+			std::chrono::steady_clock::now(),
+			(*sysinfoJSON)["free_heap"].get<int>(),
+			(*sysinfoJSON)["min_free_heap"].get<int>(),
+		};
 
-		res = m_httpClient.Post("/api/v1/pump/hot-water-mode", pumpControlJSON.dump(), "application/json");
+		// The low-water mark only ever falls while the machine stays up
+		if (m_lastMinFreeHeap && data.health->minFreeHeap > *m_lastMinFreeHeap)
+			deviceRestarted("minimum free heap rose");
+
+		m_lastMinFreeHeap = data.health->minFreeHeap;
 	}
 
-	res = m_httpClient.Get("/api/v1/sys/info");
-	auto sysinfoJSON = nlohmann::json::parse(res->body);
-	auto freeHeap = sysinfoJSON["free_heap"].get<int>();
-	auto minFreeHeap = sysinfoJSON["min_free_heap"].get<int>();
+	// A restart found this poll is handled by the handshake on the next one
+	if (! canWrite() || ! m_handshakeDone)
+		return true;
+
+	// What the machine has: read back when fetched this poll, otherwise what was last pushed
+	auto remote = m_pushed;
+	std::optional<BoilerState> state;
 
-	static auto printTrigger = 20;
-	if (!--printTrigger)
+	if (tempJSON)
 	{
-		printf("Core -- Heap: %dKB (%dKB)\n", freeHeap/1024, minFreeHeap/1024);
+		remote.brewTarget = (*tempJSON)["brew"].get<float>();
+		remote.steamTarget = (*tempJSON)["steam"].get<float>();
+		state = static_cast<BoilerState>(data.state);
+	}
 
-		printTrigger = 20;
+	if (pressureJSON)
+	{
+		remote.brewPressure = (*pressureJSON)["brew"].get<float>();
+		remote.pumpDuty = (*pressureJSON)["manual-duty"].get<float>();
+		remote.pumpManualMode = (*pressureJSON)["manual-mode"].get<bool>();
+		remote.hotWaterMode = (*pressureJSON)["hot-water-mode"].get<bool>();
 	}
 
-	res = m_httpClient.Get("/api/v1/pid/terms");
-	auto pidTermsJSON = nlohmann::json::parse(res->body);
+	return pushSettings(remote, state, pollStart);
+}
+
+bool BoilerController::verifyPIDTerms()
+{
+	auto now = std::chrono::steady_clock::now();
+
+	if (! m_subscriptions.active(EndpointPIDTerms) && now - m_lastPIDCheck < kPIDVerifyInterval)
+		return true;
+
+	auto pidTermsJSON = getJSON(m_httpClient, "/api/v1/pid/terms");
+	if (! pidTermsJSON)
+		return false;
 
-	PIDTerms boilerPID = {
-		 pidTermsJSON["BoilerPID"][0].get<float>(),
-		 pidTermsJSON["BoilerPID"][1].get<float>(),
-		 pidTermsJSON["BoilerPID"][2].get<float>(),
+	m_lastPIDCheck = now;
+
+	PIDTerms remoteBoilerPID = {
+		(*pidTermsJSON)["BoilerPID"][0].get<float>(),
+		(*pidTermsJSON)["BoilerPID"][1].get<float>(),
+		(*pidTermsJSON)["BoilerPID"][2].get<float>(),
 	};
 
-	PIDTerms pumpPID = {
-		 pidTermsJSON["PumpPID"][0].get<float>(),
-		 pidTermsJSON["PumpPID"][1].get<float>(),
-		 pidTermsJSON["PumpPID"][2].get<float>(),
+	PIDTerms remotePumpPID = {
+		(*pidTermsJSON)["PumpPID"][0].get<float>(),
+		(*pidTermsJSON)["PumpPID"][1].get<float>(),
+		(*pidTermsJSON)["PumpPID"][2].get<float>(),
 	};
 
-	if (boilerPID != m_boilerPID)
+	// Back on its defaults: handshake again before anything else this poll
+	if (remoteBoilerPID != m_pushedBoilerPID || remotePumpPID != m_pushedPumpPID)
+		deviceRestarted("PID terms were reset");
+
+	return true;
+}
+
+void BoilerController::deviceRestarted(const char* evidence)
+{
+	printf("BoilerController: %s restarted (%s)\n", m_url.c_str(), evidence);
+
+	// Default terms, inhibited, nothing of ours pushed and its clock starting over
+	m_handshakeDone = false;
+	m_pushed = {};
+	m_clockSync.reset();
+}
+
+bool BoilerController::pushSettings(const RemoteSettings& remote, std::optional<BoilerState> state, int64_t pollStart)
+{
+	float brewTarget, steamTarget, brewPressure, pumpDuty;
+	bool pumpManualMode, hotWaterMode;
+	PIDTerms boilerPID, pumpPID;
+
+	{
+		std::lock_guard lock(m_settingsMutex);
+		brewTarget = m_brewTarget;
+		steamTarget = m_steamTarget;
+		brewPressure = m_brewTargetPressure;
+		pumpDuty = m_pumpDuty;
+		pumpManualMode = m_pumpManualMode;
+		hotWaterMode = m_hotWaterMode;
+		boilerPID = m_boilerPID;
+		pumpPID = m_pumpPID;
+	}
+
+	if (remote.brewTarget != brewTarget)
 	{
-		 nlohmann::json pidSetJSON;
-		 pidSetJSON["BoilerPID"] = { m_boilerPID.Kp, m_boilerPID.Ki, m_boilerPID.Kd };
+		nlohmann::json brewTargetJSON;
+		brewTargetJSON["brewTarget"] = brewTarget;
+
+		if (! postJSON(m_httpClient, "/api/v1/temp/raw", brewTargetJSON))
+			return false;
 
-		 res = m_httpClient.Post("/api/v1/pid/terms", pidSetJSON.dump(), "application/json");
+		m_pushed.brewTarget = brewTarget;
 	}
 
-	if (pumpPID != m_pumpPID)
+	if (remote.steamTarget != steamTarget)
 	{
-		 nlohmann::json pidSetJSON;
-		 pidSetJSON["PumpPID"]   = { m_pumpPID.Kp, m_pumpPID.Ki, m_pumpPID.Kd };
+		nlohmann::json steamTargetJSON;
+		steamTargetJSON["steamTarget"] = steamTarget;
+
+		if (! postJSON(m_httpClient, "/api/v1/temp/raw", steamTargetJSON))
+			return false;
 
-		 res = m_httpClient.Post("/api/v1/pid/terms", pidSetJSON.dump(), "application/json");
+		m_pushed.steamTarget = steamTarget;
 	}
 
-	return { boilerTemp, targetTemp, pressureCurrent, pumpDuty, boilerState};
-}
+	// The profile streams its own setpoints, so the static one goes out again afterwards
+	if (m_pressureProfileActive)
+	{
+		m_pushed.brewPressure.reset();
+	}
+	else if (remote.brewPressure != brewPressure)
+	{
+		nlohmann::json brewTargetJSON;
+		brewTargetJSON["brewTarget"] = brewPressure;
+
+		if (! postJSON(m_httpClient, "/api/v1/pressure/raw", brewTargetJSON))
+			return false;
+
+		m_pushed.brewPressure = brewPressure;
+	}
+
+	// A pump stop holds until the machine reports the shot has ended; a stop
+	// issued meanwhile fails the exchange and stays in force
+	auto pumpStopTime = m_pumpStopTime.load();
+	if (pumpStopTime && pumpStopTime < pollStart)
+	{
+		// Decided on the machine's state as of this poll, even when temperature isn't subscribed
+		if (! state)
+		{
+			auto tempJSON = getJSON(m_httpClient, "/api/v1/temp/raw");
+			if (! tempJSON)
+				return false;
+
+			state = static_cast<BoilerState>((*tempJSON)["state"].get<int>());
+		}
+
+		if (*state != BoilerState::Brewing && m_pumpStopTime.compare_exchange_strong(pumpStopTime, 0))
+		{
+			pumpStopTime = 0;
+
+			// stopPump() wrote to the machine behind the poll's back
+			m_pushed.pumpDuty.reset();
+			m_pushed.pumpManualMode.reset();
+		}
+	}
+
+	auto duty = pumpStopTime ? 0.0f : pumpDuty;
+	auto manualMode = pumpStopTime ? true : pumpManualMode;
+
+	if (remote.pumpDuty != duty || remote.pumpManualMode != manualMode)
+	{
+		nlohmann::json pumpControlJSON;
+		pumpControlJSON["Duty"] = duty;
+		pumpControlJSON["ManualControl"] = manualMode;
+
+		if (! postJSON(m_httpClient, "/api/v1/pump/manual-control", pumpControlJSON))
+			return false;
+
+		m_pushed.pumpDuty = duty;
+		m_pushed.pumpManualMode = manualMode;
+	}
+
+	if (remote.hotWaterMode != hotWaterMode)
+	{
+		nlohmann::json pumpControlJSON;
+		pumpControlJSON["HotWaterMode"] = hotWaterMode;
+
+		if (! postJSON(m_httpClient, "/api/v1/pump/hot-water-mode", pumpControlJSON))
+			return false;
+
+		m_pushed.hotWaterMode = hotWaterMode;
+	}
+
+	// Terms the machine lost are caught by verifyPIDTerms(), so only local changes are pushed here
+	if (m_pushedBoilerPID != boilerPID)
+	{
+		nlohmann::json pidSetJSON;
+		pidSetJSON["BoilerPID"] = { boilerPID.Kp, boilerPID.Ki, boilerPID.Kd };
+
+		if (! postJSON(m_httpClient, "/api/v1/pid/terms", pidSetJSON))
+			return false;
+
+		m_pushedBoilerPID = boilerPID;
+	}
+
+	if (m_pushedPumpPID != pumpPID)
+	{
+		nlohmann::json pidSetJSON;
+		pidSetJSON["PumpPID"] = { pumpPID.Kp, pumpPID.Ki, pumpPID.Kd };
+
+		if (! postJSON(m_httpClient, "/api/v1/pid/terms", pidSetJSON))
+			return false;
+
+		m_pushedPumpPID = pumpPID;
+	}
+
+	return true;
+}
\ No newline at end of file
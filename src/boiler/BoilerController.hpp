@@ -1,9 +1,19 @@
 #pragma once
 
 #include "SettingsManager.hpp"
+#include "PollReactor.hpp"
+#include "ClockSync.hpp"
+#include "DeviceHealth.hpp"
+#include "EndpointSubscriptions.hpp"
+#include "QuantizedValue.hpp"
+#include "SampleExtrapolator.hpp"
+#include "TelemetryClock.hpp"
 
+#include <atomic>
 #include <set>
 #include <future>
+#include <optional>
+#include <mutex>
 
 #include <httplib.h>
 
@@ -16,6 +26,17 @@ enum class BoilerState
 	Idle,
 };
 
+struct BoilerSample
+{
+	std::chrono::steady_clock::time_point timestamp;
+
+	float		currentTemp;
+	float		targetTemp;
+	float		currentPressure;
+	float		pumpDuty;
+	BoilerState	state;
+};
+
 class BoilerTemperatureDelegate
 {
 public:
@@ -25,21 +46,85 @@ public:
 	virtual void onBoilerSteamTempChanged(float temp)		{ };
 	virtual void onBoilerStateChanged(BoilerState state)	{ };
 	virtual void onBoilerPressureChanged(float temp)		{ };
+	virtual void onBoilerPumpDutyChanged(float duty)		{ };
+};
+
+// Receives every raw, timestamped poll result (before display quantization)
+class BoilerSampleDelegate
+{
+public:
+	virtual void onBoilerSample(const BoilerSample& sample)	{ };
+};
+
+// Called on the poll thread as soon as a sample is parsed; must not block
+class BoilerRealtimeDelegate
+{
+public:
+	virtual void onBoilerSampleRealtime(const BoilerSample& sample)	{ };
 };
 
 class BoilerController : public SettingDelegate
 {
 public:
+	// Remote endpoints, as subscription mask bits
+	enum Endpoint : uint32_t
+	{
+		EndpointTemperature	= 1 << 0,
+		EndpointPressure	= 1 << 1,
+		EndpointSysInfo		= 1 << 2,
+		EndpointPIDTerms	= 1 << 3,
+	};
+
+	static constexpr uint32_t kSampleEndpoints = EndpointTemperature | EndpointPressure;
+
+	enum class Mode
+	{
+		// Pushes the local settings (setpoints, PID terms, pump modes) to the machine
+		Control,
+
+		// Only reads; the machine keeps its own settings. For dashboards watching many machines
+		Monitor,
+	};
+
+	// Polls run on the shared reactor when one is given, otherwise on their own thread.
+	// Nothing is requested until the first poll, so construction never blocks.
+	BoilerController(const std::string& url, PollReactor* reactor = nullptr, Mode mode = Mode::Control);
+	~BoilerController();
 
-	BoilerController(const std::string& url);
+	// Offline controller with no remote, fed through injectSample() (e.g. replay)
+	BoilerController();
 
-	void registerBoilerTemperatureDelegate(BoilerTemperatureDelegate* delegate);
+	// Registration subscribes the endpoints the delegate needs; only subscribed endpoints are polled
+	void registerBoilerTemperatureDelegate(BoilerTemperatureDelegate* delegate, uint32_t endpoints = kSampleEndpoints);
 	void deregisterBoilerTemperatureDelegate(BoilerTemperatureDelegate* delegate);
 
+	void registerBoilerSampleDelegate(BoilerSampleDelegate* delegate);
+	void deregisterBoilerSampleDelegate(BoilerSampleDelegate* delegate);
+
+	// Main thread; waits out a poll in flight so the previous delegate is safe to destroy on return
+	void setRealtimeDelegate(BoilerRealtimeDelegate* delegate);
+
+	// Heap usage from sys/info, for HealthMonitor
+	void registerHealthDelegate(DeviceHealthSampleDelegate* delegate);
+	void deregisterHealthDelegate(DeviceHealthSampleDelegate* delegate);
+
+	// For consumers without a delegate, e.g. a heap log on sys/info, or PID terms
+	// read back every poll rather than every kPIDVerifyInterval
+	void subscribe(uint32_t endpoints);
+	void unsubscribe(uint32_t endpoints);
+
+	// Setpoints go out with the next poll, whether or not anything is reading
 	void setBoilerBrewTemp(float temp);
 	void setBoilerSteamTemp(float temp);
 	void setBoilerBrewPressure(float pressure);
 
+	// Forces the pump off until the current shot ends. Safe to call from any thread.
+	void stopPump();
+
+	// While a pressure profile streams setpoints the static brew pressure is not enforced
+	void setPressureProfileActive(bool active)	{ m_pressureProfileActive = active; }
+	float getBoilerBrewPressure() const			{ return m_brewTargetPressure; }
+
 	void updateBoilerTargetTemp(float temp);
 	void updateBoilerCurrentTemp(float temp);
 	void updateBoilerCurrentPressure(float pressure);
@@ -48,6 +133,25 @@ public:
 
 	void tick();
 
+	void injectSample(const BoilerSample& sample);
+	void setClock(const TelemetryClock* clock);
+
+	UpdateCounters getCurrentTempUpdateCounters() const		{ return m_currentTempDisplay.counters(); }
+	UpdateCounters getCurrentPressureUpdateCounters() const	{ return m_currentPressureDisplay.counters(); }
+
+	const ClockSync& getClockSync() const	{ return m_clockSync; }
+
+	const std::string& url() const			{ return m_url; }
+
+	// False once kMaxFailedPolls polls in a row have failed, until one succeeds
+	bool reachable() const					{ return m_reachable; }
+
+	// True once per loss of connection, e.g. to resolve the hostname again
+	bool takeConnectionLost()				{ return m_connectionLost.exchange(false); }
+
+	// True while a poll is in flight or waiting on the reactor; the destructor blocks on it
+	bool pollPending() const				{ return m_pollFut.valid() && m_pollFut.wait_for(std::chrono::seconds(0)) != std::future_status::ready; }
+
 	// SettingDelegate i/f
 	void onChanged(const std::string& key, float val) override;
 	void onChanged(const std::string& key, bool val) override;
@@ -60,6 +164,13 @@ private:
 		float 	currentPressure;
 		float	pumpDuty;
 		int		state;
+
+		std::chrono::steady_clock::time_point timestamp;
+
+		// False when no sample endpoint was fetched this cycle
+		bool	sampled;
+
+		std::optional<DeviceHealthSample> health;
 	};
 
 	struct PIDTerms
@@ -71,12 +182,58 @@ private:
 		auto operator<=>(const PIDTerms&) const = default;
 	};
 
+	// Settings as last pushed to the machine; unset until pushed on this connection
+	struct RemoteSettings
+	{
+		std::optional<float>	brewTarget;
+		std::optional<float>	steamTarget;
+		std::optional<float>	brewPressure;
+		std::optional<float>	pumpDuty;
+		std::optional<bool>		pumpManualMode;
+		std::optional<bool>		hotWaterMode;
+	};
+
+	void bindSettings();
+	bool canWrite() const	{ return ! m_offline && ! m_monitor; }
+
+	void processSample(const BoilerSample& sample);
+
+	void displayCurrentTemp(float temp);
+	void displayCurrentPressure(float pressure);
+
 	PollData pollRemoteServer();
+	bool pollEndpoints(PollData& data);
+	bool verifyPIDTerms();
+	void deviceRestarted(const char* evidence);
+	bool pushSettings(const RemoteSettings& remote, std::optional<BoilerState> state, int64_t pollStart);
+	void schedulePoll();
 	std::future<PollData>					m_pollFut;
+	PollReactor*							m_reactor = nullptr;
 
 	BoilerState								m_state;
 	std::set<BoilerTemperatureDelegate*>	m_delegates;
+	std::unordered_map<BoilerTemperatureDelegate*, uint32_t>	m_delegateEndpoints;
+	std::set<DeviceHealthSampleDelegate*>	m_healthDelegates;
+	EndpointSubscriptions<4>				m_subscriptions;
+	std::set<BoilerSampleDelegate*>			m_sampleDelegates;
+	std::atomic<BoilerRealtimeDelegate*>	m_realtimeDelegate = nullptr;
 	httplib::Client							m_httpClient;
+	ClockSync								m_clockSync;
+
+	// Separate connection for commands issued off the poll thread, one at a time
+	httplib::Client							m_commandClient;
+	std::mutex								m_commandMutex;
+	std::atomic<int64_t>					m_pumpStopTime = 0;
+
+	// Guards the local settings (setpoints, pump modes, PID terms): main thread writes, the poll reads
+	std::mutex								m_settingsMutex;
+	std::atomic<bool>						m_pressureProfileActive = false;
+	const TelemetryClock*					m_clock = &TelemetryClock::steady();
+	const std::string						m_url;
+	bool									m_offline = false;
+	bool									m_monitor = false;
+	std::atomic<bool>						m_reachable = true;
+	std::atomic<bool>						m_connectionLost = false;
 
 	float m_targetTemp	= 0.0;
 	float m_currentTemp	= 0.0;
@@ -85,6 +242,14 @@ private:
 	float m_brewTargetPressure = 0.0;
 	float m_brewCurrentPressure = -1.0f;
 	float m_pumpDuty = 0.0f;
+	float m_reportedPumpDuty = 0.0f;
+
+	QuantizedValue m_currentTempDisplay;
+	QuantizedValue m_currentPressureDisplay;
+
+	SampleExtrapolator m_currentTempModel;
+	SampleExtrapolator m_currentPressureModel;
+	TelemetryClock::time_point m_lastDisplayRefresh;
 
 	bool m_pumpManualMode = false;
 	bool m_hotWaterMode = false;
@@ -92,6 +257,17 @@ private:
 	PIDTerms m_boilerPID	= {0, 0, 0};
 	PIDTerms m_pumpPID		= {0, 0, 0};
 
+	// Poll thread only
+	PollData m_lastPoll			= {};
+	uint32_t m_failedPolls		= 0;
+	std::optional<int64_t> m_lastDeviceTimeUs;
+	std::optional<int> m_lastMinFreeHeap;
+	std::chrono::steady_clock::time_point m_lastPIDCheck;
+	bool m_handshakeDone		= false;
+	PIDTerms m_pushedBoilerPID	= {0, 0, 0};
+	PIDTerms m_pushedPumpPID	= {0, 0, 0};
+	RemoteSettings m_pushed;
+
 	std::unordered_map<std::string, float&> m_floatSettings;
 	std::unordered_map<std::string, bool&>  m_boolSettings;
 };
@@ -0,0 +1,90 @@
+#include "TemperatureStability.hpp"
+
+#include <cmath>
+
+namespace
+{
+	constexpr auto kMeanTolerance = 0.3f;
+	constexpr auto kStddevTolerance = 0.15f;
+	constexpr auto kSlopeTolerance = 0.02f;
+
+	// Below target by this much counts as heating up again
+	constexpr auto kHeatingBand = 2.0f;
+
+	// Long window coverage needed before stability is judged
+	constexpr auto kMinCoverage = 0.9;
+}
+
+TemperatureStability::TemperatureStability(std::chrono::steady_clock::duration shortWindow, std::chrono::steady_clock::duration longWindow, size_t capacity)
+	: m_longWindow(std::chrono::duration<double>(longWindow).count())
+	, m_short(shortWindow, capacity)
+	, m_long(longWindow, capacity)
+{
+}
+
+void TemperatureStability::registerDelegate(TemperatureStabilityDelegate* delegate)
+{
+	if (m_delegates.find(delegate) != m_delegates.end())
+		return;
+
+	m_delegates.emplace(delegate);
+
+	delegate->onThermalStabilityChanged(m_stats.stable);
+}
+
+void TemperatureStability::deregisterDelegate(TemperatureStabilityDelegate* delegate)
+{
+	if (auto it = m_delegates.find(delegate); it != m_delegates.end())
+		m_delegates.erase(it);
+}
+
+void TemperatureStability::onBoilerSample(const BoilerSample& sample)
+{
+	m_short.add(sample.timestamp, sample.currentTemp);
+	m_long.add(sample.timestamp, sample.currentTemp);
+
+	updateOvershoot(sample.currentTemp, sample.targetTemp);
+
+	m_stats.mean = static_cast<float>(m_long.mean());
+	m_stats.stddev = static_cast<float>(std::sqrt(m_long.variance()));
+	m_stats.slope = static_cast<float>(m_short.slope());
+
+	auto stable = m_long.span() >= m_longWindow * kMinCoverage
+		&& std::fabs(m_stats.mean - sample.targetTemp) < kMeanTolerance
+		&& m_stats.stddev < kStddevTolerance
+		&& std::fabs(m_stats.slope) < kSlopeTolerance;
+
+	auto changed = stable != m_stats.stable;
+	m_stats.stable = stable;
+
+	for (auto delegate : m_delegates)
+		delegate->onTemperatureStatsChanged(m_stats);
+
+	if (! changed)
+		return;
+
+	for (auto delegate : m_delegates)
+		delegate->onThermalStabilityChanged(stable);
+}
+
+void TemperatureStability::updateOvershoot(float temp, float target)
+{
+	if (temp < target - kHeatingBand)
+	{
+		m_heating = true;
+		return;
+	}
+
+	if (m_heating && temp > target)
+	{
+		// First crossing of the target since heating up
+		m_heating = false;
+		m_peak = temp;
+		m_stats.overshoot = temp - target;
+	}
+	else if (! m_heating && temp > m_peak)
+	{
+		m_peak = temp;
+		m_stats.overshoot = m_peak - target;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "RollingStats.hpp"
+
+#include <set>
+
+struct TemperatureStats
+{
+	float	mean		= 0.0f;		// long window, degC
+	float	stddev		= 0.0f;		// long window, degC
+	float	slope		= 0.0f;		// short window, degC/s
+	float	overshoot	= 0.0f;		// peak above target after the last heat-up, degC
+	bool	stable		= false;
+};
+
+class TemperatureStabilityDelegate
+{
+public:
+	virtual void onThermalStabilityChanged(bool stable)				{ };
+	virtual void onTemperatureStatsChanged(const TemperatureStats& stats)	{ };
+};
+
+/**
+ * Client-side view of how settled the boiler temperature is.
+ *
+ * Keeps a short window for the trend and a long window for mean and spread,
+ * both O(1) per sample with no allocation after construction. The boiler is
+ * reported thermally stable once the long window is full, its mean is close
+ * to target, and both the spread and the trend are small.
+ */
+class TemperatureStability : public BoilerSampleDelegate
+{
+public:
+	TemperatureStability(std::chrono::steady_clock::duration shortWindow, std::chrono::steady_clock::duration longWindow, size_t capacity);
+
+	void registerDelegate(TemperatureStabilityDelegate* delegate);
+	void deregisterDelegate(TemperatureStabilityDelegate* delegate);
+
+	const TemperatureStats& stats() const	{ return m_stats; }
+
+	// BoilerSampleDelegate i/f
+	void onBoilerSample(const BoilerSample& sample) override;
+
+private:
+	void updateOvershoot(float temp, float target);
+
+	const double					m_longWindow;
+
+	RollingStats					m_short;
+	RollingStats					m_long;
+
+	bool							m_heating = true;
+	float							m_peak = 0.0f;
+
+	TemperatureStats				m_stats;
+	std::set<TemperatureStabilityDelegate*>	m_delegates;
+};
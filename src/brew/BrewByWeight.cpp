@@ -0,0 +1,189 @@
+#include "BrewByWeight.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	// Coffee still leaving the basket once the pump is stopped
+	constexpr auto kPumpRunDown = 0.3f;
+
+	// Assumed command latency until the first stop has been measured
+	constexpr auto kDefaultCommandLatency = 0.05f;
+
+	// Drips are included in the final weight after this long
+	constexpr auto kSettleTime = std::chrono::seconds(3);
+
+	// Final weight error a shot is counted as on target within
+	constexpr auto kTargetTolerance = 0.5f;
+}
+
+BrewByWeight::BrewByWeight(BoilerController& boiler, ScalesController& scales)
+	: m_boiler(boiler)
+	, m_scales(scales)
+{
+	auto& settings = SettingsManager::get();
+
+	m_enabled = settings["BrewByWeightEnabled"].getAs<bool>();
+	m_targetWeight = settings["BrewTargetWeight"].getAs<float>();
+
+	settings["BrewByWeightEnabled"].registerDelegate(this);
+	settings["BrewTargetWeight"].registerDelegate(this);
+
+	m_boiler.registerBoilerTemperatureDelegate(this);
+	m_scales.setRealtimeDelegate(this);
+}
+
+BrewByWeight::~BrewByWeight()
+{
+	m_scales.setRealtimeDelegate(nullptr);
+	m_boiler.deregisterBoilerTemperatureDelegate(this);
+}
+
+BrewByWeight::Stats BrewByWeight::getStats() const
+{
+	std::lock_guard lock(m_statsMutex);
+	return m_stats;
+}
+
+void BrewByWeight::onBoilerStateChanged(BoilerState state)
+{
+	if (state == BoilerState::Brewing)
+	{
+		m_shotEnded = false;
+		m_armed = true;
+	}
+	else
+	{
+		m_armed = false;
+		m_shotEnded = true;
+	}
+}
+
+void BrewByWeight::onChanged(const std::string& key, float val)
+{
+	if (key == "BrewTargetWeight")
+		m_targetWeight = val;
+}
+
+void BrewByWeight::onChanged(const std::string& key, bool val)
+{
+	if (key == "BrewByWeightEnabled")
+		m_enabled = val;
+}
+
+void BrewByWeight::onScalesSampleRealtime(const ScalesSample& sample)
+{
+	if (m_armed && ! m_shotActive)
+	{
+		// Weight in the cup is counted from the first sample of the shot
+		m_shotActive = true;
+		m_fired = false;
+		m_settling = false;
+		m_startWeight = sample.weight;
+		m_lastSample = sample.timestamp;
+
+		m_flowRate.reset();
+		m_flowRate.addSample(sample.timestamp, sample.weight);
+		return;
+	}
+
+	if (m_shotActive && m_shotEnded.exchange(false))
+	{
+		m_shotActive = false;
+		m_settling = m_fired;
+		m_shotEnd = sample.timestamp;
+	}
+
+	if (m_settling && sample.timestamp - m_shotEnd >= kSettleTime)
+	{
+		m_settling = false;
+
+		std::lock_guard lock(m_statsMutex);
+		m_stats.lastFinalWeight = sample.weight - m_startWeight;
+		m_stats.lastError = m_stats.lastFinalWeight - m_stats.lastTarget;
+
+		m_stats.settledShots++;
+		m_stats.meanAbsError += (std::fabs(m_stats.lastError) - m_stats.meanAbsError) / m_stats.settledShots;
+		if (std::fabs(m_stats.lastError) <= kTargetTolerance)
+			m_stats.shotsOnTarget++;
+
+		printf("BrewByWeight -- final %.1fg (target %.1fg, error %+.2fg), %u/%u shots within %.1fg\n",
+			   m_stats.lastFinalWeight, m_stats.lastTarget, m_stats.lastError,
+			   m_stats.shotsOnTarget, m_stats.settledShots, kTargetTolerance);
+	}
+
+	if (! m_shotActive)
+		return;
+
+	auto dt = std::chrono::duration<float>(sample.timestamp - m_lastSample).count();
+	if (dt <= 0.0f)
+		return;
+
+	m_flowRate.addSample(sample.timestamp, sample.weight);
+	m_sampleInterval = m_sampleInterval > 0.0f ? m_sampleInterval + 0.2f * (dt - m_sampleInterval) : dt;
+	m_lastSample = sample.timestamp;
+
+	if (m_fired || ! m_enabled)
+		return;
+
+	auto commandLatency = kDefaultCommandLatency;
+	{
+		std::lock_guard lock(m_statsMutex);
+		if (m_stats.sampleToCommand.count)
+			commandLatency = std::chrono::duration<float>(m_stats.sampleToCommand.mean + m_stats.commandRoundTrip.mean / 2).count();
+	}
+
+	// Weight in the cup if the stop were commanded now
+	auto shotWeight = sample.weight - m_startWeight;
+	auto flowRate = std::max(0.0f, m_flowRate.flowRate());
+	auto predictedWeight = shotWeight + flowRate * (commandLatency + kPumpRunDown);
+
+	if (predictedWeight >= m_targetWeight)
+	{
+		fireStop(sample.timestamp, shotWeight);
+		return;
+	}
+
+	// The next sample would overshoot: stop at the computed time in between
+	auto untilStop = (m_targetWeight - predictedWeight) / std::max(flowRate, 1e-6f);
+	if (untilStop < m_sampleInterval)
+	{
+		auto due = sample.timestamp + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(untilStop));
+		std::this_thread::sleep_until(due);
+		fireStop(due, shotWeight + flowRate * untilStop);
+	}
+}
+
+void BrewByWeight::fireStop(std::chrono::steady_clock::time_point due, float shotWeight)
+{
+	m_fired = true;
+
+	auto commandStart = std::chrono::steady_clock::now();
+	m_boiler.stopPump();
+	auto commandEnd = std::chrono::steady_clock::now();
+
+	std::lock_guard lock(m_statsMutex);
+
+	addLatency(m_stats.sampleToCommand, commandStart - due);
+	addLatency(m_stats.commandRoundTrip, commandEnd - commandStart);
+
+	m_stats.shots++;
+	m_stats.lastTarget = m_targetWeight;
+	m_stats.lastStopWeight = shotWeight;
+
+	printf("BrewByWeight -- stop at %.1fg (target %.1fg), due->command %.1fms, command %.1fms\n",
+		   shotWeight, m_stats.lastTarget,
+		   std::chrono::duration<float, std::milli>(m_stats.sampleToCommand.last).count(),
+		   std::chrono::duration<float, std::milli>(m_stats.commandRoundTrip.last).count());
+}
+
+void BrewByWeight::addLatency(LatencyStats& stats, std::chrono::nanoseconds latency)
+{
+	stats.count++;
+	stats.last = latency;
+	stats.max = std::max(stats.max, latency);
+	stats.mean += (latency - stats.mean) / stats.count;
+}
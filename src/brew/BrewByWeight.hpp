@@ -0,0 +1,94 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "FlowRateEstimator.hpp"
+#include "ScalesController.hpp"
+#include "SettingsManager.hpp"
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * Stops the shot when the cup is predicted to reach the target weight.
+ *
+ * Runs on the scales poll thread: each weight sample updates a least-squares
+ * flow rate and the final weight is predicted from the command latency plus
+ * pump run-down. When the next sample would arrive too late the stop is
+ * scheduled for the computed time in between, and the command goes straight
+ * to the boiler from that thread without waiting for the UI.
+ */
+class BrewByWeight
+	: public BoilerTemperatureDelegate
+	, public ScalesRealtimeDelegate
+	, public SettingDelegate
+{
+public:
+	struct LatencyStats
+	{
+		uint32_t					count	= 0;
+		std::chrono::nanoseconds	last	= {};
+		std::chrono::nanoseconds	mean	= {};
+		std::chrono::nanoseconds	max		= {};
+	};
+
+	struct Stats
+	{
+		// Stop due -> stop command sent, and the command round trip
+		LatencyStats	sampleToCommand;
+		LatencyStats	commandRoundTrip;
+
+		uint32_t		shots			= 0;
+		float			lastTarget		= 0.0f;
+		float			lastStopWeight	= 0.0f;
+		float			lastFinalWeight	= 0.0f;
+
+		// Settled final weight against target
+		float			lastError		= 0.0f;
+		float			meanAbsError	= 0.0f;
+		uint32_t		settledShots	= 0;
+		uint32_t		shotsOnTarget	= 0;
+	};
+
+	BrewByWeight(BoilerController& boiler, ScalesController& scales);
+	~BrewByWeight();
+
+	Stats getStats() const;
+
+	// BoilerTemperatureDelegate i/f
+	void onBoilerStateChanged(BoilerState state) override;
+
+	// ScalesRealtimeDelegate i/f
+	void onScalesSampleRealtime(const ScalesSample& sample) override;
+
+	// SettingDelegate i/f
+	void onChanged(const std::string& key, float val) override;
+	void onChanged(const std::string& key, bool val) override;
+
+private:
+	static void addLatency(LatencyStats& stats, std::chrono::nanoseconds latency);
+
+	void fireStop(std::chrono::steady_clock::time_point due, float shotWeight);
+
+	BoilerController&		m_boiler;
+	ScalesController&		m_scales;
+
+	std::atomic<bool>		m_enabled		= false;
+	std::atomic<float>		m_targetWeight	= 0.0f;
+
+	// Set on the UI thread, consumed on the poll thread
+	std::atomic<bool>		m_armed			= false;
+	std::atomic<bool>		m_shotEnded		= false;
+
+	// Poll thread only
+	bool					m_shotActive	= false;
+	bool					m_fired			= false;
+	bool					m_settling		= false;
+	float					m_startWeight	= 0.0f;
+	FlowRateEstimator		m_flowRate;
+	float					m_sampleInterval = 0.0f;
+	std::chrono::steady_clock::time_point	m_lastSample;
+	std::chrono::steady_clock::time_point	m_shotEnd;
+
+	mutable std::mutex		m_statsMutex;
+	Stats					m_stats;
+};
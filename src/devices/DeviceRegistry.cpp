@@ -0,0 +1,153 @@
+#include "DeviceRegistry.hpp"
+
+#include <fstream>
+#include <sstream>
+
+Machine::Machine(const MachineConfig& config, const std::string& historyDirectory)
+	: config(config)
+	, history(historyDirectory + "/" + config.name)
+	, boilerHealth(config.name + "/" + config.coreHostname)
+	, scalesHealth(config.name + "/" + config.scalesHostname)
+{
+}
+
+DeviceRegistry::DeviceRegistry(PollReactor& reactor, ResolverCache& resolver, const std::string& historyDirectory)
+	: m_reactor(reactor)
+	, m_resolver(resolver)
+	, m_historyDirectory(historyDirectory)
+{
+}
+
+std::vector<MachineConfig> DeviceRegistry::loadConfig(const std::string& path)
+{
+	std::vector<MachineConfig> configs;
+
+	std::ifstream file(path);
+	if (! file)
+	{
+		printf("DeviceRegistry: Unable to open %s\n", path.c_str());
+		return configs;
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (auto comment = line.find('#'); comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream fields(line);
+
+		MachineConfig config;
+		if (! (fields >> config.name >> config.coreHostname))
+			continue;
+
+		fields >> config.scalesHostname;
+		configs.push_back(std::move(config));
+	}
+
+	return configs;
+}
+
+Machine& DeviceRegistry::add(const MachineConfig& config)
+{
+	auto& machine = *m_machines.emplace_back(std::make_unique<Machine>(config, m_historyDirectory));
+
+	for (auto delegate : m_delegates)
+		delegate->onMachineAdded(machine);
+
+	return machine;
+}
+
+void DeviceRegistry::registerDelegate(DeviceRegistryDelegate* delegate)
+{
+	m_delegates.insert(delegate);
+}
+
+void DeviceRegistry::deregisterDelegate(DeviceRegistryDelegate* delegate)
+{
+	m_delegates.erase(delegate);
+}
+
+void DeviceRegistry::tick()
+{
+	reapRetired();
+
+	for (auto& machine : m_machines)
+	{
+		connect(*machine);
+
+		if (machine->boiler)
+			machine->boiler->tick();
+
+		if (machine->scales)
+			machine->scales->tick();
+	}
+}
+
+void DeviceRegistry::connect(Machine& machine)
+{
+	if (machine.boiler && ! addressCurrent(*machine.boiler, machine.config.coreHostname))
+	{
+		printf("%s: Boiler moved, reconnecting\n", machine.config.name.c_str());
+		m_retiredBoilers.push_back(std::move(machine.boiler));
+	}
+
+	if (! machine.boiler)
+	{
+		if (auto url = m_resolver.lookup(machine.config.coreHostname))
+		{
+			printf("%s: Boiler at %s\n", machine.config.name.c_str(), url->c_str());
+
+			// The dashboard only watches; each machine keeps its own settings
+			machine.boiler = std::make_unique<BoilerController>(*url, &m_reactor, BoilerController::Mode::Monitor);
+			machine.boiler->registerBoilerSampleDelegate(&machine.history);
+			machine.boiler->registerHealthDelegate(&machine.boilerHealth);
+
+			for (auto delegate : m_delegates)
+				delegate->onBoilerConnected(machine);
+		}
+	}
+
+	if (machine.scales && ! addressCurrent(*machine.scales, machine.config.scalesHostname))
+	{
+		printf("%s: Scales moved, reconnecting\n", machine.config.name.c_str());
+		m_retiredScales.push_back(std::move(machine.scales));
+	}
+
+	if (! machine.scales && ! machine.config.scalesHostname.empty())
+	{
+		if (auto url = m_resolver.lookup(machine.config.scalesHostname))
+		{
+			printf("%s: Scales at %s\n", machine.config.name.c_str(), url->c_str());
+
+			machine.scales = std::make_unique<ScalesController>(*url, &m_reactor);
+			machine.scales->registerHealthDelegate(&machine.scalesHealth);
+
+			for (auto delegate : m_delegates)
+				delegate->onScalesConnected(machine);
+		}
+	}
+}
+
+void DeviceRegistry::reapRetired()
+{
+	auto finished = [](const auto& controller) { return ! controller->pollPending(); };
+
+	std::erase_if(m_retiredBoilers, finished);
+	std::erase_if(m_retiredScales, finished);
+}
+
+template<typename Controller>
+bool DeviceRegistry::addressCurrent(Controller& controller, const std::string& hostname)
+{
+	// The address may have changed (e.g. a new DHCP lease), so resolve it again
+	if (controller.takeConnectionLost())
+		m_resolver.invalidate(hostname);
+
+	if (controller.reachable())
+		return true;
+
+	// Keep waiting on the same address unless the name now resolves elsewhere
+	auto url = m_resolver.lookup(hostname);
+	return ! url || *url == controller.url();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "HealthMonitor.hpp"
+#include "ScalesController.hpp"
+#include "PollReactor.hpp"
+#include "ResolverCache.hpp"
+#include "TimeSeriesStore.hpp"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+struct MachineConfig
+{
+	std::string	name;
+	std::string	coreHostname;
+	std::string	scalesHostname;		// empty if the machine has no scales
+};
+
+// One espresso machine and its scales, with telemetry kept per device
+struct Machine
+{
+	Machine(const MachineConfig& config, const std::string& historyDirectory);
+
+	MachineConfig						config;
+
+	std::unique_ptr<BoilerController>	boiler;
+	std::unique_ptr<ScalesController>	scales;
+
+	TimeSeriesStore						history;
+	HealthMonitor						boilerHealth;
+	HealthMonitor						scalesHealth;
+};
+
+class DeviceRegistryDelegate
+{
+public:
+	virtual void onMachineAdded(Machine& machine)			{ };
+	virtual void onBoilerConnected(Machine& machine)		{ };
+	virtual void onScalesConnected(Machine& machine)		{ };
+};
+
+/**
+ * Owns every machine the client talks to. All controllers poll on one
+ * shared reactor and resolve through one cache, so the thread count is
+ * fixed and per-machine cost is just the controller state.
+ *
+ * tick() runs on the main thread: it connects machines as their hostnames
+ * resolve and ticks every connected controller. Boilers are watched in
+ * monitor mode, so the dashboard never writes to a machine. A device that
+ * stops answering has its hostname resolved again and is reconnected if the
+ * address changed; the old controller is retired until its last poll has
+ * finished, so dropping it never blocks the main thread.
+ */
+class DeviceRegistry
+{
+public:
+	DeviceRegistry(PollReactor& reactor, ResolverCache& resolver, const std::string& historyDirectory);
+
+	// One machine per line: "<name> <core hostname> [scales hostname]", '#' starts a comment
+	static std::vector<MachineConfig> loadConfig(const std::string& path);
+
+	Machine& add(const MachineConfig& config);
+
+	void registerDelegate(DeviceRegistryDelegate* delegate);
+	void deregisterDelegate(DeviceRegistryDelegate* delegate);
+
+	size_t size() const							{ return m_machines.size(); }
+	Machine& operator[](size_t index)			{ return *m_machines[index]; }
+
+	void tick();
+
+private:
+	void connect(Machine& machine);
+
+	// False when the controller's device stopped answering and its hostname now resolves elsewhere
+	template<typename Controller>
+	bool addressCurrent(Controller& controller, const std::string& hostname);
+
+	// Destroys retired controllers whose last poll has finished
+	void reapRetired();
+
+	PollReactor&							m_reactor;
+	ResolverCache&							m_resolver;
+	const std::string						m_historyDirectory;
+
+	std::vector<std::unique_ptr<Machine>>	m_machines;
+	std::set<DeviceRegistryDelegate*>		m_delegates;
+
+	// Replaced controllers, no longer ticked, kept until their poll future is ready
+	std::vector<std::unique_ptr<BoilerController>>	m_retiredBoilers;
+	std::vector<std::unique_ptr<ScalesController>>	m_retiredScales;
+};
@@ -0,0 +1,77 @@
+#include "PollReactor.hpp"
+
+PollReactor::PollReactor(size_t threads)
+{
+	if (threads == 0)
+		threads = 1;
+
+	m_threads.reserve(threads);
+
+	for (size_t i = 0; i < threads; ++i)
+		m_threads.emplace_back(&PollReactor::run, this);
+}
+
+PollReactor::~PollReactor()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_cv.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+size_t PollReactor::pending() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_jobs.size();
+}
+
+void PollReactor::run()
+{
+	while (1)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock lock(m_mutex);
+
+			while (1)
+			{
+				// Delayed jobs that are due join the back of the queue; when stopping
+				// they are all due, so no future is left broken
+				auto now = std::chrono::steady_clock::now();
+				while (! m_delayed.empty() && (m_stopping || m_delayed.begin()->first <= now))
+				{
+					m_jobs.push_back(std::move(m_delayed.begin()->second));
+					m_delayed.erase(m_delayed.begin());
+				}
+
+				if (! m_jobs.empty())
+					break;
+
+				if (m_stopping)
+					return;
+
+				if (m_delayed.empty())
+				{
+					m_cv.wait(lock);
+				}
+				else
+				{
+					// Copied, as another thread may take the job while this one waits
+					auto due = m_delayed.begin()->first;
+					m_cv.wait_until(lock, due);
+				}
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job();
+	}
+}
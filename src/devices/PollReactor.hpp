@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed pool of poll threads shared by every device controller.
+ *
+ * Controllers keep at most one poll outstanding, so the queue is bounded by
+ * the number of devices and the thread count stays constant however many
+ * machines are registered. Jobs run in FIFO order, which keeps polling fair
+ * when there are more devices than threads. An idle device backs off with
+ * submitAfter(), which parks the job on a timer rather than a thread.
+ */
+class PollReactor
+{
+public:
+	explicit PollReactor(size_t threads);
+	~PollReactor();
+
+	PollReactor(const PollReactor&) = delete;
+	PollReactor& operator=(const PollReactor&) = delete;
+
+	template<typename F>
+	auto submit(F&& job) -> std::future<std::invoke_result_t<F>>
+	{
+		using Result = std::invoke_result_t<F>;
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+		auto fut = task->get_future();
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_jobs.emplace_back([task] { (*task)(); });
+		}
+
+		m_cv.notify_one();
+
+		return fut;
+	}
+
+	// Queued once the delay has passed; until then it holds no thread
+	template<typename F>
+	auto submitAfter(std::chrono::steady_clock::duration delay, F&& job) -> std::future<std::invoke_result_t<F>>
+	{
+		using Result = std::invoke_result_t<F>;
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+		auto fut = task->get_future();
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_delayed.emplace(std::chrono::steady_clock::now() + delay, [task] { (*task)(); });
+		}
+
+		m_cv.notify_one();
+
+		return fut;
+	}
+
+	// Jobs waiting for a thread, not counting delayed ones still on their timer
+	size_t pending() const;
+
+private:
+	void run();
+
+	mutable std::mutex					m_mutex;
+	std::condition_variable				m_cv;
+	std::deque<std::function<void()>>	m_jobs;
+	std::multimap<std::chrono::steady_clock::time_point, std::function<void()>>	m_delayed;
+	std::vector<std::thread>			m_threads;
+	bool								m_stopping = false;
+};
@@ -0,0 +1,79 @@
+#include "ResolverCache.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+
+namespace
+{
+	constexpr auto kRetryDelay = std::chrono::seconds(2);
+}
+
+ResolverCache::ResolverCache(PollReactor& reactor, std::chrono::steady_clock::duration ttl)
+	: m_reactor(reactor)
+	, m_ttl(ttl)
+{
+}
+
+std::optional<std::string> ResolverCache::lookup(const std::string& hostname)
+{
+	std::lock_guard lock(m_mutex);
+
+	auto now = std::chrono::steady_clock::now();
+	auto& entry = m_entries[hostname];
+	auto stale = entry.url.empty() || now - entry.resolved > m_ttl;
+
+	if (stale && ! entry.pending && now - entry.attempted > kRetryDelay)
+	{
+		entry.pending = true;
+		entry.attempted = now;
+		m_reactor.submit([this, hostname] { resolve(hostname); });
+	}
+
+	if (entry.url.empty())
+		return std::nullopt;
+
+	return entry.url;
+}
+
+void ResolverCache::invalidate(const std::string& hostname)
+{
+	std::lock_guard lock(m_mutex);
+
+	if (auto it = m_entries.find(hostname); it != m_entries.end())
+		it->second.url.clear();
+}
+
+void ResolverCache::resolve(const std::string& hostname)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* result = nullptr;
+	std::string url;
+
+	// getaddrinfo is thread-safe, unlike the gethostbyname used for the single machine path
+	if (getaddrinfo(hostname.c_str(), nullptr, &hints, &result) == 0 && result)
+	{
+		char address[INET_ADDRSTRLEN];
+		auto in = reinterpret_cast<sockaddr_in*>(result->ai_addr);
+
+		if (inet_ntop(AF_INET, &in->sin_addr, address, sizeof(address)))
+			url = "http://" + std::string(address);
+	}
+
+	if (result)
+		freeaddrinfo(result);
+
+	std::lock_guard lock(m_mutex);
+
+	auto& entry = m_entries[hostname];
+	entry.pending = false;
+
+	// Keep serving the previous address if a refresh fails
+	if (! url.empty())
+	{
+		entry.url = std::move(url);
+		entry.resolved = std::chrono::steady_clock::now();
+	}
+}
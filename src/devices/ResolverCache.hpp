@@ -0,0 +1,42 @@
+#pragma once
+
+#include "PollReactor.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Shared hostname -> base URL cache. Lookups never block: a miss queues a
+ * resolution on the reactor and returns nothing until it completes, and
+ * entries are refreshed in the background once they are older than the TTL.
+ */
+class ResolverCache
+{
+public:
+	ResolverCache(PollReactor& reactor, std::chrono::steady_clock::duration ttl);
+
+	std::optional<std::string> lookup(const std::string& hostname);
+
+	// Forces the next lookup to resolve again (e.g. after the device stopped answering)
+	void invalidate(const std::string& hostname);
+
+private:
+	struct Entry
+	{
+		std::string							url;
+		std::chrono::steady_clock::time_point	resolved;
+		std::chrono::steady_clock::time_point	attempted;
+		bool								pending = false;
+	};
+
+	void resolve(const std::string& hostname);
+
+	PollReactor&							m_reactor;
+	const std::chrono::steady_clock::duration	m_ttl;
+
+	std::mutex								m_mutex;
+	std::unordered_map<std::string, Entry>	m_entries;
+};
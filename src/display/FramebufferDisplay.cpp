@@ -0,0 +1,301 @@
+#include "FramebufferDisplay.hpp"
+#include "Rotate180.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+FramebufferDisplay::~FramebufferDisplay()
+{
+	stopFlushThread();
+	close();
+}
+
+bool FramebufferDisplay::open(const char* device, Mode mode)
+{
+	m_mode = mode;
+	m_fd = ::open(device, O_RDWR);
+	if (m_fd < 0)
+	{
+		printf("FramebufferDisplay: Unable to open %s\n", device);
+		return false;
+	}
+
+	if (ioctl(m_fd, FBIOGET_VSCREENINFO, &m_originalInfo) < 0)
+	{
+		close();
+		return false;
+	}
+
+	auto pages = mode == Mode::PageFlip ? 2u : 1u;
+
+	auto info = m_originalInfo;
+	info.bits_per_pixel = LV_COLOR_DEPTH;
+	info.xres_virtual = info.xres;
+	info.yres_virtual = info.yres * pages;
+	info.xoffset = 0;
+	info.yoffset = 0;
+
+	fb_fix_screeninfo fixedInfo;
+
+	m_reconfigured = ioctl(m_fd, FBIOPUT_VSCREENINFO, &info) == 0;
+
+	if (! m_reconfigured
+		|| ioctl(m_fd, FBIOGET_VSCREENINFO, &m_info) < 0
+		|| ioctl(m_fd, FBIOGET_FSCREENINFO, &fixedInfo) < 0)
+	{
+		printf("FramebufferDisplay: %s does not support %ubpp with %u pages\n", device, LV_COLOR_DEPTH, pages);
+		close();
+		return false;
+	}
+
+	// In page flip mode the pages are LVGL's draw buffers, which are unpadded
+	auto strideMismatch = mode == Mode::PageFlip && fixedInfo.line_length != m_info.xres * sizeof(lv_color_t);
+
+	// The rotate kernel works on RGB565
+	auto depthMismatch = m_info.bits_per_pixel != LV_COLOR_DEPTH || (mode == Mode::RotateCopy && LV_COLOR_DEPTH != 16);
+
+	if (depthMismatch || m_info.yres_virtual < m_info.yres * pages || strideMismatch)
+	{
+		printf("FramebufferDisplay: %s has an incompatible layout (%ubpp, %u lines, stride %u)\n",
+			   device, m_info.bits_per_pixel, m_info.yres_virtual, fixedInfo.line_length);
+		close();
+		return false;
+	}
+
+	m_stride = fixedInfo.line_length / sizeof(lv_color_t);
+	m_mappingSize = static_cast<size_t>(fixedInfo.line_length) * m_info.yres * pages;
+	auto mapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		m_mappingSize = 0;
+		close();
+		return false;
+	}
+
+	m_mapping = static_cast<uint8_t*>(mapping);
+	m_pages[0] = reinterpret_cast<lv_color_t*>(m_mapping);
+	m_pages[1] = pages > 1 ? reinterpret_cast<lv_color_t*>(m_mapping + static_cast<size_t>(fixedInfo.line_length) * m_info.yres) : nullptr;
+
+	printf("FramebufferDisplay: %ux%u, %s on %s\n", m_info.xres, m_info.yres,
+		   mode == Mode::PageFlip ? "page flipping" : "rotate-180 copy", device);
+
+	return true;
+}
+
+lv_disp_t* FramebufferDisplay::registerDisplay(ParallelRenderer* renderer)
+{
+	auto pixels = m_info.xres * m_info.yres;
+
+	lv_disp_drv_init(&m_drv);
+	m_drv.draw_buf = &m_drawBuf;
+	m_drv.hor_res = m_info.xres;
+	m_drv.ver_res = m_info.yres;
+	m_drv.user_data = this;
+
+	if (m_mode == Mode::PageFlip)
+	{
+		lv_disp_draw_buf_init(&m_drawBuf, m_pages[0], m_pages[1], pixels);
+
+		m_drv.flush_cb = &FramebufferDisplay::flushCb;
+		m_drv.direct_mode = 1;
+	}
+	else
+	{
+		m_buffers[0] = std::make_unique<lv_color_t[]>(pixels);
+		m_buffers[1] = std::make_unique<lv_color_t[]>(pixels);
+		lv_disp_draw_buf_init(&m_drawBuf, m_buffers[0].get(), m_buffers[1].get(), pixels);
+
+		// Rotated by the flush rather than by LVGL; input is still mapped through the rotation
+		m_drv.flush_cb = &FramebufferDisplay::rotateFlushCb;
+		m_drv.wait_cb = &FramebufferDisplay::waitCb;
+		m_drv.rotated = LV_DISP_ROT_180;
+		m_drv.sw_rotate = 0;
+
+		m_flushThread = std::thread(&FramebufferDisplay::flushWorker, this);
+	}
+
+	if (renderer)
+		ParallelRenderer::prepare(&m_drv);
+
+	auto disp = lv_disp_drv_register(&m_drv);
+
+	if (renderer)
+		renderer->attach(disp);
+
+	return disp;
+}
+
+void FramebufferDisplay::setPresentDelegate(DisplayPresentDelegate* delegate)
+{
+	std::unique_lock lock(m_flushMutex);
+	m_flushCv.wait(lock, [this] { return ! m_flushBusy; });
+
+	m_presentDelegate = delegate;
+	m_frameAreas.clear();
+}
+
+void FramebufferDisplay::flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+	auto display = static_cast<FramebufferDisplay*>(drv->user_data);
+
+	// Areas of the frame only show once the whole page is flipped
+	if (display->m_presentDelegate)
+		display->m_frameAreas.push_back(*area);
+
+	// Areas are already in place; only the end of the frame needs work
+	if (lv_disp_flush_is_last(drv))
+	{
+		display->flip(color_p);
+
+		if (auto delegate = display->m_presentDelegate)
+		{
+			for (auto& frameArea : display->m_frameAreas)
+				delegate->onAreaPresented(frameArea);
+		}
+
+		display->m_frameAreas.clear();
+	}
+
+	lv_disp_flush_ready(drv);
+}
+
+void FramebufferDisplay::rotateFlushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+	auto display = static_cast<FramebufferDisplay*>(drv->user_data);
+
+	// LVGL keeps at most one flush in flight, and renders into the other buffer meanwhile
+	{
+		std::lock_guard lock(display->m_flushMutex);
+		display->m_flushJob = FlushJob { *area, color_p };
+		display->m_flushBusy = true;
+	}
+
+	display->m_flushCv.notify_all();
+}
+
+void FramebufferDisplay::waitCb(lv_disp_drv_t* drv)
+{
+	auto display = static_cast<FramebufferDisplay*>(drv->user_data);
+
+	// Sleep rather than let LVGL spin while the flush thread finishes
+	std::unique_lock lock(display->m_flushMutex);
+	display->m_flushCv.wait(lock, [display] { return ! display->m_flushBusy; });
+}
+
+void FramebufferDisplay::flushWorker()
+{
+	while (1)
+	{
+		FlushJob job;
+
+		{
+			std::unique_lock lock(m_flushMutex);
+			m_flushCv.wait(lock, [this] { return m_stopping || m_flushJob; });
+
+			if (m_stopping)
+				return;
+
+			job = *m_flushJob;
+			m_flushJob.reset();
+		}
+
+		auto width = static_cast<size_t>(lv_area_get_width(&job.area));
+		auto height = static_cast<size_t>(lv_area_get_height(&job.area));
+
+		// The area's bottom-right corner becomes the top-left of its rotated rectangle
+		auto x = m_info.xres - 1 - job.area.x2;
+		auto y = m_info.yres - 1 - job.area.y2;
+
+		auto dst = reinterpret_cast<uint16_t*>(m_pages[0]) + y * m_stride + x;
+		rotate180Copy(dst, m_stride, reinterpret_cast<const uint16_t*>(job.pixels), width, width, height);
+
+		// Only replaced while no flush is busy, so safe to use outside the lock
+		if (m_presentDelegate)
+			m_presentDelegate->onAreaPresented(job.area);
+
+		{
+			std::lock_guard lock(m_flushMutex);
+			lv_disp_flush_ready(&m_drv);
+			m_flushBusy = false;
+		}
+
+		m_flushCv.notify_all();
+	}
+}
+
+void FramebufferDisplay::stopFlushThread()
+{
+	if (! m_flushThread.joinable())
+		return;
+
+	{
+		std::lock_guard lock(m_flushMutex);
+		m_stopping = true;
+	}
+
+	m_flushCv.notify_all();
+	m_flushThread.join();
+}
+
+void FramebufferDisplay::flip(lv_color_t* rendered)
+{
+	auto page = rendered == m_pages[0] ? 0 : 1;
+
+	m_info.yoffset = page * m_info.yres;
+
+	if (m_vsync)
+	{
+		int screen = 0;
+		m_vsync = ioctl(m_fd, FBIO_WAITFORVSYNC, &screen) == 0;
+	}
+
+	ioctl(m_fd, FBIOPAN_DISPLAY, &m_info);
+
+	syncPages(m_pages[page], m_pages[1 - page]);
+}
+
+void FramebufferDisplay::syncPages(const lv_color_t* shown, lv_color_t* hidden)
+{
+	auto disp = _lv_refr_get_disp_refreshing();
+	auto stride = static_cast<lv_coord_t>(m_info.xres);
+
+	for (uint16_t i = 0; i < disp->inv_p; ++i)
+	{
+		if (disp->inv_area_joined[i])
+			continue;
+
+		auto& area = disp->inv_areas[i];
+		auto width = static_cast<size_t>(lv_area_get_width(&area)) * sizeof(lv_color_t);
+
+		for (auto y = area.y1; y <= area.y2; ++y)
+		{
+			auto offset = static_cast<size_t>(y) * stride + area.x1;
+			memcpy(hidden + offset, shown + offset, width);
+		}
+	}
+}
+
+void FramebufferDisplay::close()
+{
+	if (m_mapping)
+	{
+		munmap(m_mapping, m_mappingSize);
+		m_mapping = nullptr;
+	}
+
+	if (m_fd >= 0)
+	{
+		// Leave the console as it was found
+		if (m_reconfigured)
+			ioctl(m_fd, FBIOPUT_VSCREENINFO, &m_originalInfo);
+
+		m_reconfigured = false;
+
+		::close(m_fd);
+		m_fd = -1;
+	}
+}
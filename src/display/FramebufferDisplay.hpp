@@ -0,0 +1,113 @@
+#pragma once
+
+#include "lvgl.h"
+#include "ParallelRenderer.hpp"
+
+#include <linux/fb.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Told when a flushed area is actually on the panel, not just handed to the driver
+class DisplayPresentDelegate
+{
+public:
+	virtual void onAreaPresented(const lv_area_t& area)	{ };
+};
+
+/**
+ * LVGL display rendering straight into the Linux framebuffer.
+ *
+ * The framebuffer is reconfigured to a double-height virtual screen and
+ * LVGL runs in direct mode with one page as each draw buffer. When a frame
+ * is complete the rendered page is panned on screen with FBIOPAN_DISPLAY
+ * (after FBIO_WAITFORVSYNC where the driver supports it) and the areas
+ * redrawn this frame are copied to the other page, which LVGL draws the
+ * next frame into. There is no full-frame copy and no draw buffer in
+ * process memory.
+ *
+ * Direct mode cannot rotate in software, so the panel must be rotated by
+ * the firmware (e.g. lcd_rotate=2 on the Pi).
+ *
+ * RotateCopy mode keeps LVGL's own draw buffers and rotates the panel by
+ * 180° while copying each flushed area into the framebuffer in one pass
+ * (see Rotate180.hpp), instead of LVGL's software rotation followed by a
+ * second copy. The copy runs on a flush thread so LVGL renders into one
+ * draw buffer while the other is being copied out.
+ */
+class FramebufferDisplay
+{
+public:
+	enum class Mode
+	{
+		PageFlip,
+		RotateCopy,
+	};
+
+	FramebufferDisplay() = default;
+	~FramebufferDisplay();
+
+	FramebufferDisplay(const FramebufferDisplay&) = delete;
+	FramebufferDisplay& operator=(const FramebufferDisplay&) = delete;
+
+	// False if the device cannot be set up for the mode at LVGL's colour depth
+	bool open(const char* device, Mode mode);
+
+	// Blends in bands on the renderer's threads when given one
+	lv_disp_t* registerDisplay(ParallelRenderer* renderer = nullptr);
+
+	// Called on the flush thread in RotateCopy mode, once the area is copied out;
+	// in PageFlip mode for each area of the frame once it is flipped. Main thread;
+	// waits out a flush in flight so the previous delegate is safe to destroy on return
+	void setPresentDelegate(DisplayPresentDelegate* delegate);
+
+private:
+	static void flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+	static void rotateFlushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+	static void waitCb(lv_disp_drv_t* drv);
+
+	void flushWorker();
+	void stopFlushThread();
+
+	void flip(lv_color_t* rendered);
+	void syncPages(const lv_color_t* shown, lv_color_t* hidden);
+	void close();
+
+	Mode						m_mode = Mode::PageFlip;
+	int							m_fd = -1;
+	fb_var_screeninfo			m_originalInfo = {};
+	fb_var_screeninfo			m_info = {};
+
+	uint8_t*					m_mapping = nullptr;
+	size_t						m_mappingSize = 0;
+	size_t						m_stride = 0;		// pixels
+	lv_color_t*					m_pages[2] = {};
+
+	std::unique_ptr<lv_color_t[]>	m_buffers[2];
+
+	bool						m_reconfigured = false;
+	bool						m_vsync = true;
+
+	DisplayPresentDelegate*		m_presentDelegate = nullptr;
+	std::vector<lv_area_t>		m_frameAreas;		// PageFlip, while a delegate is set
+
+	struct FlushJob
+	{
+		lv_area_t			area;
+		const lv_color_t*	pixels;
+	};
+
+	std::thread					m_flushThread;
+	std::mutex					m_flushMutex;
+	std::condition_variable		m_flushCv;
+	std::optional<FlushJob>		m_flushJob;
+	bool						m_flushBusy = false;
+	bool						m_stopping = false;
+
+	lv_disp_draw_buf_t			m_drawBuf;
+	lv_disp_drv_t				m_drv;
+};
@@ -0,0 +1,155 @@
+#include "ParallelRenderer.hpp"
+
+namespace
+{
+	// Smaller blends cost less than waking the workers
+	constexpr int32_t kMinParallelPixels = 16 * 1024;
+}
+
+ParallelRenderer::ParallelRenderer(size_t bands)
+	: m_bands(bands < 1 ? 1 : bands)
+	, m_bandClips(m_bands)
+	, m_stats(m_bands)
+{
+	// Band 0 runs on the rendering thread
+	for (size_t band = 1; band < m_bands; ++band)
+		m_workers.emplace_back(&ParallelRenderer::worker, this, band);
+}
+
+ParallelRenderer::~ParallelRenderer()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_startCv.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void ParallelRenderer::prepare(lv_disp_drv_t* drv)
+{
+	drv->draw_ctx_init = &ParallelRenderer::initDrawCtx;
+	drv->draw_ctx_size = sizeof(DrawCtx);
+}
+
+void ParallelRenderer::attach(lv_disp_t* disp)
+{
+	auto drawCtx = reinterpret_cast<DrawCtx*>(disp->driver->draw_ctx);
+	drawCtx->renderer = this;
+}
+
+void ParallelRenderer::resetStats()
+{
+	m_stats.assign(m_bands, {});
+	m_serialBlends = 0;
+}
+
+void ParallelRenderer::initDrawCtx(lv_disp_drv_t* drv, lv_draw_ctx_t* drawCtx)
+{
+	lv_draw_sw_init_ctx(drv, drawCtx);
+
+	auto ctx = reinterpret_cast<DrawCtx*>(drawCtx);
+	ctx->base.blend = &ParallelRenderer::blendCb;
+	ctx->renderer = nullptr;
+}
+
+void ParallelRenderer::blendCb(lv_draw_ctx_t* drawCtx, const lv_draw_sw_blend_dsc_t* dsc)
+{
+	auto renderer = reinterpret_cast<DrawCtx*>(drawCtx)->renderer;
+
+	if (renderer)
+		renderer->blend(drawCtx, dsc);
+	else
+		lv_draw_sw_blend_basic(drawCtx, dsc);
+}
+
+void ParallelRenderer::blend(lv_draw_ctx_t* drawCtx, const lv_draw_sw_blend_dsc_t* dsc)
+{
+	lv_area_t area;
+
+	if (! _lv_area_intersect(&area, dsc->blend_area, drawCtx->clip_area))
+		return;
+
+	auto height = lv_area_get_height(&area);
+
+	if (m_bands == 1 || lv_area_get_size(&area) < kMinParallelPixels || height < static_cast<lv_coord_t>(m_bands))
+	{
+		m_serialBlends++;
+		lv_draw_sw_blend_basic(drawCtx, dsc);
+		return;
+	}
+
+	// Equal row bands in a fixed order, so the split is the same every frame
+	for (size_t band = 0; band < m_bands; ++band)
+	{
+		auto& clip = m_bandClips[band];
+		clip = area;
+		clip.y1 = area.y1 + static_cast<lv_coord_t>(height * band / m_bands);
+		clip.y2 = area.y1 + static_cast<lv_coord_t>(height * (band + 1) / m_bands) - 1;
+	}
+
+	{
+		std::lock_guard lock(m_mutex);
+		m_drawCtx = drawCtx;
+		m_dsc = dsc;
+		m_remaining = m_bands - 1;
+		m_generation++;
+	}
+
+	m_startCv.notify_all();
+
+	blendBand(0);
+
+	std::unique_lock lock(m_mutex);
+	m_doneCv.wait(lock, [this] { return m_remaining == 0; });
+}
+
+void ParallelRenderer::blendBand(size_t band)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// A shallow copy with a narrower clip confines LVGL's blend to this band's rows
+	auto bandCtx = *m_drawCtx;
+	bandCtx.clip_area = &m_bandClips[band];
+
+	lv_draw_sw_blend_basic(&bandCtx, m_dsc);
+
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	auto& stats = m_stats[band];
+	stats.blends++;
+	stats.pixels += lv_area_get_size(&m_bandClips[band]);
+	stats.totalMs += elapsed;
+	if (elapsed > stats.maxMs)
+		stats.maxMs = elapsed;
+}
+
+void ParallelRenderer::worker(size_t band)
+{
+	uint64_t seen = 0;
+
+	while (1)
+	{
+		{
+			std::unique_lock lock(m_mutex);
+			m_startCv.wait(lock, [this, seen] { return m_stopping || m_generation != seen; });
+
+			if (m_stopping)
+				return;
+
+			seen = m_generation;
+		}
+
+		blendBand(band);
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_remaining--;
+		}
+
+		m_doneCv.notify_one();
+	}
+}
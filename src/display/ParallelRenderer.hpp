@@ -0,0 +1,84 @@
+#pragma once
+
+#include "lvgl.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Opt-in multi-core software rendering.
+ *
+ * LVGL's object tree and draw state are single-threaded, so this works at
+ * the one stage that is pure pixel work: the software blend. Blends
+ * covering at least kMinParallelPixels are split into horizontal bands by
+ * narrowing the clip area, and the bands are blended concurrently by the
+ * calling thread and a fixed set of workers. Each band writes only its own
+ * rows with LVGL's own blend routine, so the result is pixel-identical to
+ * a single-threaded blend and needs no merge beyond waiting for all bands.
+ *
+ * Large fills and image blits (full-screen transitions, backgrounds) gain
+ * the most; masked shapes are blended a line at a time and stay serial.
+ */
+class ParallelRenderer
+{
+public:
+	struct BandStats
+	{
+		uint64_t	blends = 0;
+		uint64_t	pixels = 0;
+		double		totalMs = 0.0;
+		double		maxMs = 0.0;
+	};
+
+	explicit ParallelRenderer(size_t bands);
+	~ParallelRenderer();
+
+	ParallelRenderer(const ParallelRenderer&) = delete;
+	ParallelRenderer& operator=(const ParallelRenderer&) = delete;
+
+	// Call on the driver before lv_disp_drv_register() so its draw context has room for the renderer
+	static void prepare(lv_disp_drv_t* drv);
+
+	// Call after registration; blends run in bands from then on
+	void attach(lv_disp_t* disp);
+
+	size_t bands() const							{ return m_bands; }
+	const std::vector<BandStats>& stats() const		{ return m_stats; }
+	uint64_t serialBlends() const					{ return m_serialBlends; }
+	void resetStats();
+
+private:
+	struct DrawCtx
+	{
+		lv_draw_sw_ctx_t	base;
+		ParallelRenderer*	renderer;
+	};
+
+	static void initDrawCtx(lv_disp_drv_t* drv, lv_draw_ctx_t* drawCtx);
+	static void blendCb(lv_draw_ctx_t* drawCtx, const lv_draw_sw_blend_dsc_t* dsc);
+
+	void blend(lv_draw_ctx_t* drawCtx, const lv_draw_sw_blend_dsc_t* dsc);
+	void blendBand(size_t band);
+	void worker(size_t band);
+
+	const size_t						m_bands;
+	std::vector<std::thread>			m_workers;
+
+	std::mutex							m_mutex;
+	std::condition_variable				m_startCv;
+	std::condition_variable				m_doneCv;
+	uint64_t							m_generation = 0;
+	size_t								m_remaining = 0;
+	bool								m_stopping = false;
+
+	// Current job, written before a generation starts and read-only during it
+	lv_draw_ctx_t*						m_drawCtx = nullptr;
+	const lv_draw_sw_blend_dsc_t*		m_dsc = nullptr;
+	std::vector<lv_area_t>				m_bandClips;
+
+	std::vector<BandStats>				m_stats;
+	uint64_t							m_serialBlends = 0;
+};
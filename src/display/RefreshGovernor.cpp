@@ -0,0 +1,148 @@
+#include "RefreshGovernor.hpp"
+
+#include <cstdio>
+
+namespace
+{
+	constexpr uint32_t kIdleAfter = 3000;				// ms
+	constexpr uint32_t kSuspendAfter = 10 * 60 * 1000;	// ms
+
+	constexpr uint32_t kIdleRefreshPeriod = 250;		// ms
+	constexpr uint32_t kIdleInputPeriod = 250;			// ms
+
+	const char* stateName(RefreshGovernor::State state)
+	{
+		switch (state)
+		{
+		case RefreshGovernor::State::Active:	return "active";
+		case RefreshGovernor::State::Idle:		return "idle";
+		case RefreshGovernor::State::Suspended:	return "suspended";
+		}
+
+		return "";
+	}
+}
+
+RefreshGovernor::RefreshGovernor(lv_disp_t* disp, std::string backlightPath)
+	: m_disp(disp)
+	, m_backlightPath(std::move(backlightPath))
+{
+}
+
+RefreshGovernor::~RefreshGovernor()
+{
+	enter(State::Active);
+}
+
+void RefreshGovernor::tick()
+{
+	if (m_brewing)
+	{
+		enter(State::Active);
+		return;
+	}
+
+	auto inactive = lv_disp_get_inactive_time(m_disp);
+
+	if (inactive >= kSuspendAfter)
+		enter(State::Suspended);
+	else if (inactive < kIdleAfter || lv_anim_count_running() > 0)
+		enter(State::Active);
+	else
+		enter(State::Idle);
+}
+
+void RefreshGovernor::onShotStarted()
+{
+	m_brewing = true;
+}
+
+void RefreshGovernor::onShotStopped(float seconds)
+{
+	m_brewing = false;
+	lv_disp_trig_activity(m_disp);
+}
+
+void RefreshGovernor::onInputEvents(EvdevInput& input)
+{
+	// The screen was dark, so the touch cannot have been aimed at anything
+	if (m_state == State::Suspended && input.indev()->driver->type == LV_INDEV_TYPE_POINTER)
+		lv_indev_wait_release(input.indev());
+
+	lv_disp_trig_activity(m_disp);
+	enter(State::Active);
+}
+
+void RefreshGovernor::enter(State state)
+{
+	if (state == m_state)
+		return;
+
+	auto refreshTimer = _lv_disp_get_refr_timer(m_disp);
+
+	switch (state)
+	{
+	case State::Active:
+		lv_timer_set_period(refreshTimer, LV_DISP_DEF_REFR_PERIOD);
+		setInputPeriod(LV_INDEV_DEF_READ_PERIOD);
+		break;
+
+	case State::Idle:
+		lv_timer_set_period(refreshTimer, kIdleRefreshPeriod);
+		setInputPeriod(kIdleInputPeriod);
+		break;
+
+	case State::Suspended:
+		lv_timer_pause(refreshTimer);
+		for (auto indev = lv_indev_get_next(nullptr); indev; indev = lv_indev_get_next(indev))
+			lv_timer_pause(indev->driver->read_timer);
+		break;
+	}
+
+	if (m_state == State::Suspended)
+	{
+		lv_timer_resume(refreshTimer);
+		for (auto indev = lv_indev_get_next(nullptr); indev; indev = lv_indev_get_next(indev))
+			lv_timer_resume(indev->driver->read_timer);
+	}
+
+	// Run on this pass of lv_timer_handler() rather than after a slow period
+	if (state == State::Active)
+	{
+		lv_timer_ready(refreshTimer);
+		for (auto indev = lv_indev_get_next(nullptr); indev; indev = lv_indev_get_next(indev))
+			lv_timer_ready(indev->driver->read_timer);
+	}
+
+	// Active <-> Idle follows every touch, so only the backlight switches are logged
+	if (state == State::Suspended || m_state == State::Suspended)
+	{
+		setBacklight(state != State::Suspended);
+		printf("RefreshGovernor: %s -> %s\n", stateName(m_state), stateName(state));
+	}
+
+	m_state = state;
+}
+
+void RefreshGovernor::setInputPeriod(uint32_t period)
+{
+	for (auto indev = lv_indev_get_next(nullptr); indev; indev = lv_indev_get_next(indev))
+		lv_timer_set_period(indev->driver->read_timer, period);
+}
+
+void RefreshGovernor::setBacklight(bool on)
+{
+	if (m_backlightPath.empty())
+		return;
+
+	// bl_power follows FB_BLANK: 0 is on, anything else is off
+	auto file = fopen(m_backlightPath.c_str(), "w");
+	if (! file)
+	{
+		printf("RefreshGovernor: Unable to open %s\n", m_backlightPath.c_str());
+		return;
+	}
+
+	fputs(on ? "0" : "1", file);
+	fclose(file);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "EvdevInput.hpp"
+#include "ShotSession.hpp"
+
+#include "lvgl.h"
+
+#include <string>
+
+/**
+ * Runs LVGL's display refresh and input read timers at full rate only
+ * while something is happening on screen.
+ *
+ * Active:		touch or key activity within kIdleAfter, a running animation
+ *				or a shot in progress. Default LVGL periods.
+ * Idle:		static screen. Refresh and input drop to a few Hz; data
+ *				still updates, just less often.
+ * Suspended:	no activity for kSuspendAfter. Refresh and input timers are
+ *				paused and the backlight is switched off.
+ *
+ * Wake does not wait for the slow input timer: the governor is told about
+ * input events as soon as the main loop sees them, before LVGL reads them,
+ * and switches straight back to Active on the same pass. A touch that wakes
+ * a dark screen is swallowed rather than pressing whatever is under it.
+ */
+class RefreshGovernor : public ShotTimerDelegate, public EvdevInputDelegate
+{
+public:
+	enum class State
+	{
+		Active,
+		Idle,
+		Suspended,
+	};
+
+	// An empty backlight path leaves the backlight alone
+	RefreshGovernor(lv_disp_t* disp, std::string backlightPath);
+	~RefreshGovernor();
+
+	RefreshGovernor(const RefreshGovernor&) = delete;
+	RefreshGovernor& operator=(const RefreshGovernor&) = delete;
+
+	// On the UI thread, once per main loop pass
+	void tick();
+
+	State state() const		{ return m_state; }
+
+	// ShotTimerDelegate i/f
+	void onShotStarted() override;
+	void onShotStopped(float seconds) override;
+
+	// EvdevInputDelegate i/f
+	void onInputEvents(EvdevInput& input) override;
+
+private:
+	void enter(State state);
+	void setInputPeriod(uint32_t period);
+	void setBacklight(bool on);
+
+	lv_disp_t*			m_disp;
+	std::string			m_backlightPath;
+
+	State				m_state = State::Active;
+	bool				m_brewing = false;
+};
@@ -0,0 +1,98 @@
+#include "Rotate180.hpp"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void rotate180Copy(uint16_t* dst, size_t dstStride, const uint16_t* src, size_t srcStride, size_t width, size_t height)
+{
+	for (size_t y = 0; y < height; ++y)
+		rotate180Row(dst + (height - 1 - y) * dstStride, src + y * srcStride, width);
+}
+
+void rotate180RowScalar(uint16_t* dst, const uint16_t* src, size_t width)
+{
+	auto end = src + width;
+
+	for (size_t x = 0; x < width; ++x)
+		dst[x] = *--end;
+}
+
+#if defined(__ARM_NEON)
+
+void rotate180Row(uint16_t* dst, const uint16_t* src, size_t width)
+{
+	size_t x = 0;
+
+	// 16 pixels per iteration: reverse within each 64-bit half, then swap the halves
+	for (; x + 16 <= width; x += 16)
+	{
+		auto in = src + width - x - 16;
+
+		auto lo = vrev64q_u16(vld1q_u16(in));
+		auto hi = vrev64q_u16(vld1q_u16(in + 8));
+
+		vst1q_u16(dst + x, vcombine_u16(vget_high_u16(hi), vget_low_u16(hi)));
+		vst1q_u16(dst + x + 8, vcombine_u16(vget_high_u16(lo), vget_low_u16(lo)));
+	}
+
+	rotate180RowScalar(dst + x, src, width - x);
+}
+
+const char* rotate180KernelName()
+{
+	return "neon";
+}
+
+#elif defined(__SSE2__)
+
+namespace
+{
+	inline __m128i reverse(__m128i v)
+	{
+		v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	}
+}
+
+void rotate180Row(uint16_t* dst, const uint16_t* src, size_t width)
+{
+	size_t x = 0;
+
+	for (; x + 16 <= width; x += 16)
+	{
+		auto in = reinterpret_cast<const __m128i*>(src + width - x - 16);
+
+		auto lo = _mm_loadu_si128(in);
+		auto hi = _mm_loadu_si128(in + 1);
+
+		auto out = reinterpret_cast<__m128i*>(dst + x);
+
+		_mm_storeu_si128(out, reverse(hi));
+		_mm_storeu_si128(out + 1, reverse(lo));
+	}
+
+	rotate180RowScalar(dst + x, src, width - x);
+}
+
+const char* rotate180KernelName()
+{
+	return "sse2";
+}
+
+#else
+
+void rotate180Row(uint16_t* dst, const uint16_t* src, size_t width)
+{
+	rotate180RowScalar(dst, src, width);
+}
+
+const char* rotate180KernelName()
+{
+	return "scalar";
+}
+
+#endif
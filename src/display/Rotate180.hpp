@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fused 180° rotate-and-copy for RGB565 pixels.
+ *
+ * rotate180Copy() writes a width x height block so that source pixel
+ * (x, y) lands at (width - 1 - x, height - 1 - y) of the destination
+ * block. Strides are in pixels. The row kernel uses NEON on ARM and SSE2 on
+ * x86, with a scalar fallback elsewhere.
+ */
+void rotate180Copy(uint16_t* dst, size_t dstStride, const uint16_t* src, size_t srcStride, size_t width, size_t height);
+
+// Reverses one row of width pixels from src into dst (the buffers must not overlap)
+void rotate180Row(uint16_t* dst, const uint16_t* src, size_t width);
+void rotate180RowScalar(uint16_t* dst, const uint16_t* src, size_t width);
+
+const char* rotate180KernelName();
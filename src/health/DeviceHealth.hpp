@@ -0,0 +1,18 @@
+#pragma once
+
+#include <chrono>
+
+struct DeviceHealthSample
+{
+	std::chrono::steady_clock::time_point timestamp;
+
+	int		freeHeap;		// bytes
+	int		minFreeHeap;	// bytes, low-water mark since the device booted
+};
+
+// Receives every sys/info poll result; registering subscribes the sys/info endpoint
+class DeviceHealthSampleDelegate
+{
+public:
+	virtual void onDeviceHealthSample(const DeviceHealthSample& sample)	{ };
+};
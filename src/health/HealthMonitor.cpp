@@ -0,0 +1,118 @@
+#include "HealthMonitor.hpp"
+
+namespace
+{
+	constexpr auto kPointInterval = std::chrono::seconds(10);
+	constexpr auto kSeriesSpan = std::chrono::hours(24);
+	constexpr auto kTrendWindow = std::chrono::hours(6);
+	constexpr auto kMinTrendSpan = std::chrono::hours(1);
+
+	constexpr auto kHeapFloor = 8 * 1024;
+	constexpr auto kCriticalHeap = 16 * 1024;
+
+	// Slopes shallower than this are noise (allocator churn, fragmentation)
+	constexpr auto kMinLeakSlope = 256.0f;		// bytes per hour
+
+	constexpr auto kLeakHorizon = 24.0f;		// hours
+	constexpr auto kCriticalHorizon = 1.0f;		// hours
+
+	// An alert clears only once the estimate is this much past its horizon
+	constexpr auto kClearFactor = 1.25f;
+
+	constexpr size_t kSeriesCapacity = kSeriesSpan / kPointInterval;
+	constexpr size_t kTrendCapacity = kTrendWindow / kPointInterval + 1;
+}
+
+HealthMonitor::HealthMonitor(const std::string& device)
+	: m_device(device)
+	, m_points(kSeriesCapacity)
+	, m_freeHeap(kTrendWindow, kTrendCapacity)
+{
+}
+
+void HealthMonitor::registerDelegate(DeviceHealthDelegate* delegate)
+{
+	m_delegates.insert(delegate);
+}
+
+void HealthMonitor::deregisterDelegate(DeviceHealthDelegate* delegate)
+{
+	m_delegates.erase(delegate);
+}
+
+void HealthMonitor::onDeviceHealthSample(const DeviceHealthSample& sample)
+{
+	// The low-water mark only ever falls while the device is up
+	if (m_hasPending && sample.minFreeHeap > m_pending.minFreeHeap)
+		m_freeHeap.reset();
+
+	m_trend.freeHeap = sample.freeHeap;
+	m_trend.minFreeHeap = sample.minFreeHeap;
+
+	if (! m_hasPending || sample.timestamp - m_pending.timestamp >= kPointInterval)
+	{
+		m_pending = { sample.timestamp, sample.freeHeap, sample.minFreeHeap };
+		m_hasPending = true;
+
+		addPoint(m_pending);
+	}
+	else
+	{
+		m_pending.minFreeHeap = sample.minFreeHeap;
+	}
+
+	updateTrend();
+}
+
+void HealthMonitor::addPoint(const Point& point)
+{
+	if (m_count == m_points.size())
+		m_head = (m_head + 1) % m_points.size();
+	else
+		m_count++;
+
+	m_points[(m_head + m_count - 1) % m_points.size()] = point;
+
+	m_freeHeap.add(point.timestamp, static_cast<float>(point.freeHeap));
+}
+
+void HealthMonitor::updateTrend()
+{
+	auto alert = HeapAlert::None;
+
+	m_trend.slope = 0.0f;
+	m_trend.hoursToExhaustion = -1.0f;
+
+	if (m_freeHeap.span() >= std::chrono::duration<double>(kMinTrendSpan).count())
+	{
+		m_trend.slope = static_cast<float>(m_freeHeap.slope() * 3600.0);
+
+		if (m_trend.slope < -kMinLeakSlope)
+		{
+			auto remaining = static_cast<float>(m_trend.freeHeap - kHeapFloor);
+			m_trend.hoursToExhaustion = remaining > 0.0f ? remaining / -m_trend.slope : 0.0f;
+
+			auto criticalHorizon = m_trend.alert == HeapAlert::Critical ? kCriticalHorizon * kClearFactor : kCriticalHorizon;
+			auto leakHorizon = m_trend.alert != HeapAlert::None ? kLeakHorizon * kClearFactor : kLeakHorizon;
+
+			if (m_trend.hoursToExhaustion < criticalHorizon)
+				alert = HeapAlert::Critical;
+			else if (m_trend.hoursToExhaustion < leakHorizon)
+				alert = HeapAlert::Leaking;
+		}
+	}
+
+	if (m_trend.freeHeap < kCriticalHeap)
+		alert = HeapAlert::Critical;
+
+	if (alert != m_trend.alert)
+	{
+		m_trend.alert = alert;
+
+		for (auto delegate : m_delegates)
+			delegate->onHeapAlertChanged(m_device, alert, m_trend);
+	}
+
+	for (auto delegate : m_delegates)
+		delegate->onHeapTrendUpdated(m_device, m_trend);
+}
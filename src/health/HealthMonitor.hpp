@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DeviceHealth.hpp"
+#include "RollingStats.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+enum class HeapAlert
+{
+	None,
+	Leaking,		// heap trending down, exhausted within kLeakHorizon
+	Critical,		// exhausted within kCriticalHorizon, or already below kCriticalHeap
+};
+
+struct HeapTrend
+{
+	int			freeHeap = 0;
+	int			minFreeHeap = 0;
+	float		slope = 0.0f;					// bytes per hour, over the trend window
+	float		hoursToExhaustion = -1.0f;		// negative while the heap is not shrinking
+	HeapAlert	alert = HeapAlert::None;
+};
+
+class DeviceHealthDelegate
+{
+public:
+	virtual void onHeapAlertChanged(const std::string& device, HeapAlert alert, const HeapTrend& trend)	{ };
+
+	// After every sample, e.g. to keep a displayed projection current
+	virtual void onHeapTrendUpdated(const std::string& device, const HeapTrend& trend)	{ };
+};
+
+/**
+ * Heap history and leak detection for one remote device.
+ *
+ * sys/info samples are thinned to one point per kPointInterval and kept
+ * for kSeriesSpan. The trend is the least-squares slope of free heap over
+ * kTrendWindow; once it covers kMinTrendSpan a steady decline is
+ * extrapolated to estimate the time until the heap reaches kHeapFloor.
+ * A rise in the low-water mark means the device rebooted, which restarts
+ * the trend.
+ */
+class HealthMonitor : public DeviceHealthSampleDelegate
+{
+public:
+	struct Point
+	{
+		std::chrono::steady_clock::time_point timestamp;
+
+		int		freeHeap;
+		int		minFreeHeap;
+	};
+
+	explicit HealthMonitor(const std::string& device);
+
+	void registerDelegate(DeviceHealthDelegate* delegate);
+	void deregisterDelegate(DeviceHealthDelegate* delegate);
+
+	const std::string& device() const	{ return m_device; }
+	const HeapTrend& trend() const		{ return m_trend; }
+
+	// Oldest first
+	size_t size() const					{ return m_count; }
+	const Point& point(size_t index) const	{ return m_points[(m_head + index) % m_points.size()]; }
+
+	// DeviceHealthSampleDelegate i/f
+	void onDeviceHealthSample(const DeviceHealthSample& sample) override;
+
+private:
+	void addPoint(const Point& point);
+	void updateTrend();
+
+	const std::string				m_device;
+
+	std::vector<Point>				m_points;
+	size_t							m_head = 0;
+	size_t							m_count = 0;
+
+	Point							m_pending = {};
+	bool							m_hasPending = false;
+
+	RollingStats					m_freeHeap;
+	HeapTrend						m_trend;
+	std::set<DeviceHealthDelegate*>	m_delegates;
+};
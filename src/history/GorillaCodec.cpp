@@ -0,0 +1,208 @@
+#include "GorillaCodec.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+	constexpr uint64_t mask(uint32_t bits)
+	{
+		return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+	}
+
+	constexpr int64_t signExtend(uint64_t value, uint32_t bits)
+	{
+		auto shift = 64 - bits;
+		return static_cast<int64_t>(value << shift) >> shift;
+	}
+
+	// Delta-of-delta buckets: control prefix, prefix length, payload bits
+	struct DodBucket
+	{
+		uint32_t	prefix;
+		uint32_t	prefixBits;
+		uint32_t	payloadBits;
+	};
+
+	constexpr DodBucket kDodBuckets[] = {
+		{ 0b10,		2,	7 },
+		{ 0b110,	3,	9 },
+		{ 0b1110,	4,	12 },
+		{ 0b1111,	4,	64 },
+	};
+}
+
+void BitWriter::write(uint64_t value, uint32_t bits)
+{
+	while (bits)
+	{
+		auto offset = m_bitCount % 64;
+		if (offset == 0)
+			m_words.push_back(0);
+
+		auto space = static_cast<uint32_t>(64 - offset);
+		auto n = std::min(space, bits);
+		auto chunk = (value >> (bits - n)) & mask(n);
+
+		m_words.back() |= chunk << (space - n);
+
+		bits -= n;
+		m_bitCount += n;
+	}
+}
+
+uint64_t BitReader::read(uint32_t bits)
+{
+	uint64_t value = 0;
+
+	while (bits && m_position < m_bitCount)
+	{
+		auto offset = m_position % 64;
+		auto space = static_cast<uint32_t>(64 - offset);
+		auto n = std::min(space, bits);
+		auto chunk = (m_words[m_position / 64] >> (space - n)) & mask(n);
+
+		value = n == 64 ? chunk : (value << n) | chunk;
+
+		bits -= n;
+		m_position += n;
+	}
+
+	return value;
+}
+
+void GorillaEncoder::append(int64_t timestampMs, float value)
+{
+	auto bits = std::bit_cast<uint32_t>(value);
+
+	if (m_count++ == 0)
+	{
+		m_firstTimestamp = m_prevTimestamp = timestampMs;
+		m_prevValue = bits;
+
+		m_writer.write(static_cast<uint64_t>(timestampMs), 64);
+		m_writer.write(bits, 32);
+		return;
+	}
+
+	auto delta = timestampMs - m_prevTimestamp;
+	auto dod = delta - m_prevDelta;
+
+	m_prevTimestamp = timestampMs;
+	m_prevDelta = delta;
+
+	if (dod == 0)
+	{
+		m_writer.write(0, 1);
+	}
+	else
+	{
+		for (auto& bucket : kDodBuckets)
+		{
+			auto limit = bucket.payloadBits >= 64 ? INT64_MAX : int64_t(1) << (bucket.payloadBits - 1);
+
+			if (bucket.payloadBits >= 64 || (dod >= -limit && dod < limit))
+			{
+				m_writer.write(bucket.prefix, bucket.prefixBits);
+				m_writer.write(static_cast<uint64_t>(dod) & mask(bucket.payloadBits), bucket.payloadBits);
+				break;
+			}
+		}
+	}
+
+	auto xorValue = bits ^ m_prevValue;
+	m_prevValue = bits;
+
+	if (xorValue == 0)
+	{
+		m_writer.write(0, 1);
+		return;
+	}
+
+	auto leading = static_cast<uint32_t>(std::countl_zero(xorValue));
+	auto trailing = static_cast<uint32_t>(std::countr_zero(xorValue));
+
+	if (m_haveWindow && leading >= m_prevLeading && trailing >= m_prevTrailing)
+	{
+		// Meaningful bits fit in the previous window
+		auto length = 32 - m_prevLeading - m_prevTrailing;
+
+		m_writer.write(0b10, 2);
+		m_writer.write(xorValue >> m_prevTrailing, length);
+		return;
+	}
+
+	auto length = 32 - leading - trailing;
+
+	m_writer.write(0b11, 2);
+	m_writer.write(leading, 5);
+	m_writer.write(length - 1, 5);
+	m_writer.write(xorValue >> trailing, length);
+
+	m_prevLeading = leading;
+	m_prevTrailing = trailing;
+	m_haveWindow = true;
+}
+
+bool GorillaDecoder::next(int64_t& timestampMs, float& value)
+{
+	if (m_remaining == 0)
+		return false;
+
+	--m_remaining;
+
+	if (m_first)
+	{
+		m_first = false;
+
+		m_prevTimestamp = static_cast<int64_t>(m_reader.read(64));
+		m_prevValue = static_cast<uint32_t>(m_reader.read(32));
+
+		timestampMs = m_prevTimestamp;
+		value = std::bit_cast<float>(m_prevValue);
+		return true;
+	}
+
+	int64_t dod = 0;
+
+	if (m_reader.read(1))
+	{
+		uint32_t prefix = 0b1;
+		uint32_t prefixBits = 1;
+
+		for (auto& bucket : kDodBuckets)
+		{
+			while (prefixBits < bucket.prefixBits)
+			{
+				prefix = (prefix << 1) | static_cast<uint32_t>(m_reader.read(1));
+				prefixBits++;
+			}
+
+			if (prefix == bucket.prefix)
+			{
+				dod = signExtend(m_reader.read(bucket.payloadBits), bucket.payloadBits);
+				break;
+			}
+		}
+	}
+
+	m_prevDelta += dod;
+	m_prevTimestamp += m_prevDelta;
+
+	if (m_reader.read(1))
+	{
+		if (m_reader.read(1))
+		{
+			m_prevLeading = static_cast<uint32_t>(m_reader.read(5));
+			auto length = static_cast<uint32_t>(m_reader.read(5)) + 1;
+			m_prevTrailing = 32 - m_prevLeading - length;
+		}
+
+		auto length = 32 - m_prevLeading - m_prevTrailing;
+		m_prevValue ^= static_cast<uint32_t>(m_reader.read(length)) << m_prevTrailing;
+	}
+
+	timestampMs = m_prevTimestamp;
+	value = std::bit_cast<float>(m_prevValue);
+	return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Gorilla-style compression of (timestamp, float) samples, after
+ * Pelkonen et al., "Gorilla: A Fast, Scalable, In-Memory Time Series Database".
+ *
+ * Timestamps are stored as delta-of-delta in variable length buckets, values
+ * as the XOR against the previous value with leading/trailing zero elision.
+ * A steadily polled, slowly moving series costs a couple of bits per sample.
+ */
+class BitWriter
+{
+public:
+	void write(uint64_t value, uint32_t bits);
+
+	const std::vector<uint64_t>& words() const	{ return m_words; }
+	size_t bitCount() const						{ return m_bitCount; }
+
+private:
+	std::vector<uint64_t>	m_words;
+	size_t					m_bitCount = 0;
+};
+
+class BitReader
+{
+public:
+	BitReader(const uint64_t* words, size_t bitCount)
+		: m_words(words)
+		, m_bitCount(bitCount)
+	{ }
+
+	uint64_t read(uint32_t bits);
+	bool exhausted() const		{ return m_position >= m_bitCount; }
+
+private:
+	const uint64_t*	m_words;
+	size_t			m_bitCount;
+	size_t			m_position = 0;
+};
+
+class GorillaEncoder
+{
+public:
+	void append(int64_t timestampMs, float value);
+
+	size_t count() const						{ return m_count; }
+	int64_t firstTimestamp() const				{ return m_firstTimestamp; }
+	int64_t lastTimestamp() const				{ return m_prevTimestamp; }
+
+	const std::vector<uint64_t>& words() const	{ return m_writer.words(); }
+	size_t bitCount() const						{ return m_writer.bitCount(); }
+
+private:
+	BitWriter	m_writer;
+	size_t		m_count = 0;
+
+	int64_t		m_firstTimestamp = 0;
+	int64_t		m_prevTimestamp = 0;
+	int64_t		m_prevDelta = 0;
+
+	uint32_t	m_prevValue = 0;
+	uint32_t	m_prevLeading = 0;
+	uint32_t	m_prevTrailing = 0;
+	bool		m_haveWindow = false;
+};
+
+class GorillaDecoder
+{
+public:
+	GorillaDecoder(const uint64_t* words, size_t bitCount, size_t count)
+		: m_reader(words, bitCount)
+		, m_remaining(count)
+	{ }
+
+	bool next(int64_t& timestampMs, float& value);
+
+private:
+	BitReader	m_reader;
+	size_t		m_remaining;
+	bool		m_first = true;
+
+	int64_t		m_prevTimestamp = 0;
+	int64_t		m_prevDelta = 0;
+
+	uint32_t	m_prevValue = 0;
+	uint32_t	m_prevLeading = 0;
+	uint32_t	m_prevTrailing = 0;
+};
@@ -0,0 +1,107 @@
+#include "RollupSeries.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	// GCC/Clang vector extensions: SSE on x86, NEON on aarch64
+	typedef float		v4f	__attribute__((vector_size(16)));
+	typedef double		v2d	__attribute__((vector_size(16)));
+	typedef uint32_t	v4u	__attribute__((vector_size(16)));
+
+	template<typename V, typename T>
+	V load(const T* src)
+	{
+		V v;
+		memcpy(&v, src, sizeof(v));
+		return v;
+	}
+}
+
+void RollupSeries::append(const RollupBucket& bucket)
+{
+	m_starts.push_back(bucket.startMs);
+	m_mins.push_back(bucket.min);
+	m_maxs.push_back(bucket.max);
+	m_sums.push_back(bucket.sum);
+	m_counts.push_back(bucket.count);
+
+	// Drop the oldest eighth at once to keep trimming amortized O(1)
+	if (m_starts.size() > m_maxBuckets + m_maxBuckets / 8)
+		trim();
+}
+
+void RollupSeries::trim()
+{
+	auto excess = static_cast<std::ptrdiff_t>(m_starts.size() - m_maxBuckets);
+
+	m_starts.erase(m_starts.begin(), m_starts.begin() + excess);
+	m_mins.erase(m_mins.begin(), m_mins.begin() + excess);
+	m_maxs.erase(m_maxs.begin(), m_maxs.begin() + excess);
+	m_sums.erase(m_sums.begin(), m_sums.begin() + excess);
+	m_counts.erase(m_counts.begin(), m_counts.begin() + excess);
+}
+
+RollupBucket RollupSeries::bucket(size_t index) const
+{
+	return { m_starts[index], m_mins[index], m_maxs[index], m_sums[index], m_counts[index] };
+}
+
+std::pair<size_t, size_t> RollupSeries::indexRange(int64_t fromMs, int64_t toMs) const
+{
+	auto first = std::lower_bound(m_starts.begin(), m_starts.end(), fromMs);
+	auto last = std::lower_bound(first, m_starts.end(), toMs);
+
+	return { first - m_starts.begin(), last - m_starts.begin() };
+}
+
+RollupAggregate RollupSeries::aggregate(int64_t fromMs, int64_t toMs) const
+{
+	auto [first, last] = indexRange(fromMs, toMs);
+
+	if (first == last)
+		return {};
+
+	constexpr auto kInf = std::numeric_limits<float>::infinity();
+
+	v4f mins = { kInf, kInf, kInf, kInf };
+	v4f maxs = { -kInf, -kInf, -kInf, -kInf };
+	v2d sums = { 0.0, 0.0 };
+	v4u counts = { 0, 0, 0, 0 };
+
+	auto i = first;
+	for (; i + 4 <= last; i += 4)
+	{
+		auto mn = load<v4f>(&m_mins[i]);
+		auto mx = load<v4f>(&m_maxs[i]);
+
+		mins = mn < mins ? mn : mins;
+		maxs = mx > maxs ? mx : maxs;
+
+		sums += load<v2d>(&m_sums[i]) + load<v2d>(&m_sums[i + 2]);
+		counts += load<v4u>(&m_counts[i]);
+	}
+
+	RollupAggregate result;
+
+	result.min = std::min({ mins[0], mins[1], mins[2], mins[3] });
+	result.max = std::max({ maxs[0], maxs[1], maxs[2], maxs[3] });
+
+	double sum = sums[0] + sums[1];
+	uint64_t count = uint64_t(counts[0]) + counts[1] + counts[2] + counts[3];
+
+	for (; i < last; ++i)
+	{
+		result.min = std::min(result.min, m_mins[i]);
+		result.max = std::max(result.max, m_maxs[i]);
+		sum += m_sums[i];
+		count += m_counts[i];
+	}
+
+	result.count = count;
+	result.mean = count ? static_cast<float>(sum / count) : 0.0f;
+
+	return result;
+}
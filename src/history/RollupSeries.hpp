@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RollupBucket
+{
+	int64_t		startMs;
+	float		min;
+	float		max;
+	double		sum;
+	uint32_t	count;
+};
+
+struct RollupAggregate
+{
+	float		min		= 0.0f;
+	float		max		= 0.0f;
+	float		mean	= 0.0f;
+	uint64_t	count	= 0;
+};
+
+/**
+ * Closed downsampling buckets of one resolution, stored column-wise so
+ * aggregate queries are straight vector scans over contiguous arrays.
+ */
+class RollupSeries
+{
+public:
+	explicit RollupSeries(size_t maxBuckets)
+		: m_maxBuckets(maxBuckets)
+	{ }
+
+	void append(const RollupBucket& bucket);
+
+	// Buckets starting within [fromMs, toMs)
+	RollupAggregate aggregate(int64_t fromMs, int64_t toMs) const;
+
+	size_t size() const						{ return m_starts.size(); }
+	RollupBucket bucket(size_t index) const;
+
+	std::pair<size_t, size_t> indexRange(int64_t fromMs, int64_t toMs) const;
+
+private:
+	void trim();
+
+	const size_t			m_maxBuckets;
+
+	std::vector<int64_t>	m_starts;
+	std::vector<float>		m_mins;
+	std::vector<float>		m_maxs;
+	std::vector<double>		m_sums;
+	std::vector<uint32_t>	m_counts;
+};
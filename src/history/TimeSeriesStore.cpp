@@ -0,0 +1,696 @@
+#include "TimeSeriesStore.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+#include <unistd.h>
+
+namespace
+{
+	constexpr int64_t kMsPerDay = 24 * 60 * 60 * 1000;
+
+	constexpr size_t kBlockSamples = 4096;
+	constexpr int64_t kBlockDurationMs = 10 * 60 * 1000;
+	constexpr int64_t kCheckpointMs = 10 * 1000;
+
+	constexpr int64_t kDailyRetentionDays = 31;
+
+	struct LevelConfig
+	{
+		const char*	suffix;
+		int64_t		widthMs;
+		size_t		maxBuckets;
+		bool		persisted;
+	};
+
+	// 1 s buckets would take more space than the compressed raw data, so
+	// they only cover the last day in memory
+	constexpr LevelConfig kLevels[] = {
+		{ "1s",	1000,			24 * 60 * 60,		false },
+		{ "1m",	60 * 1000,		90 * 24 * 60,		true },
+		{ "1h",	60 * 60 * 1000,	10 * 365 * 24,		true },
+	};
+
+	constexpr const char* kSeriesNames[] = {
+		"temperature",
+		"pressure",
+	};
+
+	constexpr uint32_t kBlockMagic = 0x42524f47; // "GORB"
+
+	struct BlockHeader
+	{
+		uint32_t	magic;
+		uint32_t	count;
+		int64_t		firstMs;
+		int64_t		lastMs;
+		uint64_t	bitCount;
+	};
+
+	// startMs, min, max, sum, count; written field by field so the file has no padding
+	constexpr size_t kBucketRecordSize = sizeof(int64_t) + 2 * sizeof(float) + sizeof(double) + sizeof(uint32_t);
+
+	template<typename T>
+	uint8_t* put(uint8_t* out, T value)
+	{
+		memcpy(out, &value, sizeof(value));
+		return out + sizeof(value);
+	}
+
+	template<typename T>
+	const uint8_t* take(const uint8_t* in, T& value)
+	{
+		memcpy(&value, in, sizeof(value));
+		return in + sizeof(value);
+	}
+
+	std::array<uint8_t, kBucketRecordSize> serializeBucket(const RollupBucket& bucket)
+	{
+		std::array<uint8_t, kBucketRecordSize> record;
+
+		auto out = put(record.data(), bucket.startMs);
+		out = put(out, bucket.min);
+		out = put(out, bucket.max);
+		out = put(out, bucket.sum);
+		put(out, bucket.count);
+
+		return record;
+	}
+
+	RollupBucket parseBucket(const uint8_t* record)
+	{
+		RollupBucket bucket;
+
+		auto in = take(record, bucket.startMs);
+		in = take(in, bucket.min);
+		in = take(in, bucket.max);
+		in = take(in, bucket.sum);
+		take(in, bucket.count);
+
+		return bucket;
+	}
+
+	// Block header followed by its words, as stored in the raw files
+	std::vector<uint8_t> serializeBlock(const GorillaEncoder& block)
+	{
+		BlockHeader header = {
+			kBlockMagic,
+			static_cast<uint32_t>(block.count()),
+			block.firstTimestamp(),
+			block.lastTimestamp(),
+			block.bitCount(),
+		};
+
+		auto& words = block.words();
+
+		std::vector<uint8_t> bytes(sizeof(header) + words.size() * sizeof(uint64_t));
+		memcpy(bytes.data(), &header, sizeof(header));
+		memcpy(bytes.data() + sizeof(header), words.data(), words.size() * sizeof(uint64_t));
+
+		return bytes;
+	}
+
+	// Written aside and renamed over, so a crash mid-write keeps the previous version
+	void replaceFile(const std::string& path, const uint8_t* bytes, size_t size)
+	{
+		auto temporary = path + ".tmp";
+
+		std::unique_ptr<FILE, int (*)(FILE*)> file(fopen(temporary.c_str(), "wb"), &fclose);
+		if (! file)
+			return;
+
+		auto written = fwrite(bytes, 1, size, file.get()) == size
+			&& fflush(file.get()) == 0
+			&& fsync(fileno(file.get())) == 0;
+
+		file.reset();
+
+		std::error_code ec;
+		if (written)
+			std::filesystem::rename(temporary, path, ec);
+		else
+			std::filesystem::remove(temporary, ec);
+	}
+
+	int64_t dayOf(int64_t timestampMs)
+	{
+		return timestampMs / kMsPerDay;
+	}
+
+	std::string dateOf(int64_t day)
+	{
+		time_t seconds = day * (kMsPerDay / 1000);
+		struct tm utc;
+		gmtime_r(&seconds, &utc);
+
+		char date[16];
+		strftime(date, sizeof(date), "%Y%m%d", &utc);
+
+		return date;
+	}
+
+	void merge(RollupBucket& into, const RollupBucket& bucket)
+	{
+		if (into.count == 0)
+		{
+			into.min = bucket.min;
+			into.max = bucket.max;
+		}
+		else
+		{
+			into.min = std::min(into.min, bucket.min);
+			into.max = std::max(into.max, bucket.max);
+		}
+
+		into.sum += bucket.sum;
+		into.count += bucket.count;
+	}
+}
+
+TimeSeriesStore::SeriesState::SeriesState()
+	: block(std::make_unique<GorillaEncoder>())
+	, levels{ Level(kLevels[0].maxBuckets), Level(kLevels[1].maxBuckets), Level(kLevels[2].maxBuckets) }
+{
+}
+
+TimeSeriesStore::TimeSeriesStore(const std::string& directory)
+	: m_directory(directory)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(m_directory, ec);
+
+	for (size_t i = 0; i < kSeriesCount; ++i)
+	{
+		auto& state = m_series[i];
+		state.name = kSeriesNames[i];
+
+		for (size_t level = 0; level < kResolutionCount; ++level)
+		{
+			if (kLevels[level].persisted)
+				loadRollups(state, level, rollupPath(state, level));
+		}
+
+		recoverOpenBuckets(state);
+		recoverCheckpoint(state);
+	}
+
+	m_writer = std::thread(&TimeSeriesStore::writerLoop, this);
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+	{
+		std::lock_guard lock(m_stateMutex);
+
+		for (auto& state : m_series)
+		{
+			closeBlock(state);
+			checkpointOpenBuckets(state);
+		}
+	}
+
+	{
+		std::lock_guard lock(m_writeMutex);
+		m_stopping = true;
+	}
+
+	m_writeCv.notify_all();
+	m_writer.join();
+}
+
+int64_t TimeSeriesStore::wallClockMs(std::chrono::steady_clock::time_point timestamp)
+{
+	auto age = std::chrono::steady_clock::now() - timestamp;
+	auto wall = std::chrono::system_clock::now() - std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+
+	return std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count();
+}
+
+void TimeSeriesStore::onBoilerSample(const BoilerSample& sample)
+{
+	auto timestampMs = wallClockMs(sample.timestamp);
+
+	append(Series::Temperature, timestampMs, sample.currentTemp);
+	append(Series::Pressure, timestampMs, sample.currentPressure);
+}
+
+void TimeSeriesStore::append(Series series, int64_t timestampMs, float value)
+{
+	std::lock_guard lock(m_stateMutex);
+
+	auto& state = m_series[static_cast<size_t>(series)];
+	auto& block = *state.block;
+
+	if (block.count() && (block.count() >= kBlockSamples
+						  || timestampMs - block.firstTimestamp() >= kBlockDurationMs
+						  || dayOf(timestampMs) != dayOf(block.firstTimestamp())
+						  || timestampMs < block.lastTimestamp()))
+	{
+		closeBlock(state);
+	}
+
+	state.block->append(timestampMs, value);
+
+	if (state.block->count() == 1)
+		state.checkpointMs = timestampMs;
+	else if (timestampMs - state.checkpointMs >= kCheckpointMs)
+	{
+		checkpointBlock(state);
+		checkpointOpenBuckets(state);
+	}
+
+	// Rollups only move forward, late samples are kept raw only
+	if (timestampMs >= state.levels[0].open.startMs)
+		addToLevel(state, 0, { timestampMs, value, value, value, 1 });
+
+	if (auto day = dayOf(timestampMs); day != m_prunedDay)
+		pruneDailyFiles(day);
+}
+
+void TimeSeriesStore::addToLevel(SeriesState& state, size_t level, const RollupBucket& bucket)
+{
+	auto& current = state.levels[level].open;
+	auto startMs = bucket.startMs - bucket.startMs % kLevels[level].widthMs;
+
+	if (current.count && current.startMs != startMs)
+	{
+		auto closed = current;
+
+		state.levels[level].closed.append(closed);
+		writeBucket(state, level, closed);
+
+		current = {};
+
+		if (level + 1 < kResolutionCount)
+			addToLevel(state, level + 1, closed);
+
+		current.startMs = startMs;
+		merge(current, bucket);
+
+		// Straight after the bucket file, so a restart doesn't count the closed bucket twice
+		if (kLevels[level].persisted)
+			checkpointOpenBuckets(state);
+
+		return;
+	}
+
+	current.startMs = startMs;
+	merge(current, bucket);
+}
+
+void TimeSeriesStore::closeBlock(SeriesState& state)
+{
+	auto& block = *state.block;
+
+	if (! block.count())
+		return;
+
+	auto day = dayOf(block.firstTimestamp());
+
+	enqueue([this, &state, day, bytes = serializeBlock(block)] {
+		if (! state.rawFile || state.rawDay != day)
+		{
+			state.rawFile.reset(fopen(rawPath(state, day).c_str(), "ab"));
+			state.rawDay = day;
+		}
+
+		// Left checkpointed for the next start if the day file can't be written
+		if (! state.rawFile || fwrite(bytes.data(), 1, bytes.size(), state.rawFile.get()) != bytes.size())
+			return;
+
+		fflush(state.rawFile.get());
+
+		std::error_code ec;
+		std::filesystem::remove(checkpointPath(state), ec);
+	});
+
+	state.block = std::make_unique<GorillaEncoder>();
+}
+
+void TimeSeriesStore::checkpointBlock(SeriesState& state)
+{
+	state.checkpointMs = state.block->lastTimestamp();
+
+	enqueue([path = checkpointPath(state), bytes = serializeBlock(*state.block)] {
+		replaceFile(path, bytes.data(), bytes.size());
+	});
+}
+
+void TimeSeriesStore::checkpointOpenBuckets(SeriesState& state)
+{
+	// One record per level, finest first; an empty bucket has a zero count
+	std::vector<uint8_t> bytes;
+	for (auto& level : state.levels)
+	{
+		auto record = serializeBucket(level.open);
+		bytes.insert(bytes.end(), record.begin(), record.end());
+	}
+
+	enqueue([path = openBucketsPath(state), bytes = std::move(bytes)] {
+		replaceFile(path, bytes.data(), bytes.size());
+	});
+}
+
+void TimeSeriesStore::recoverOpenBuckets(SeriesState& state)
+{
+	File file(fopen(openBucketsPath(state).c_str(), "rb"));
+	if (! file)
+		return;
+
+	uint8_t record[kBucketRecordSize];
+	for (size_t level = 0; level < kResolutionCount && fread(record, sizeof(record), 1, file.get()) == 1; ++level)
+	{
+		auto bucket = parseBucket(record);
+		auto& closed = state.levels[level].closed;
+
+		// Already in the bucket file if it closed after the checkpoint was taken
+		if (! bucket.count || (closed.size() && closed.bucket(closed.size() - 1).startMs >= bucket.startMs))
+			continue;
+
+		// Closed as usual by the first sample of a later bucket
+		state.levels[level].open = bucket;
+	}
+}
+
+void TimeSeriesStore::recoverCheckpoint(SeriesState& state)
+{
+	auto path = checkpointPath(state);
+
+	File file(fopen(path.c_str(), "rb"));
+	if (! file)
+		return;
+
+	BlockHeader header;
+	std::vector<uint64_t> words;
+
+	auto valid = fread(&header, sizeof(header), 1, file.get()) == 1 && header.magic == kBlockMagic;
+	if (valid)
+	{
+		words.resize((header.bitCount + 63) / 64);
+		valid = fread(words.data(), sizeof(uint64_t), words.size(), file.get()) == words.size();
+	}
+
+	file.reset();
+
+	auto dayPath = rawPath(state, dayOf(header.firstMs));
+
+	// A crash between appending a closed block and removing its checkpoint leaves both
+	auto appended = false;
+	if (valid)
+	{
+		File raw(fopen(dayPath.c_str(), "rb"));
+
+		BlockHeader existing;
+		while (raw && ! appended && fread(&existing, sizeof(existing), 1, raw.get()) == 1 && existing.magic == kBlockMagic)
+		{
+			appended = existing.firstMs == header.firstMs;
+			fseek(raw.get(), static_cast<long>((existing.bitCount + 63) / 64 * sizeof(uint64_t)), SEEK_CUR);
+		}
+	}
+
+	if (valid && ! appended)
+	{
+		File raw(fopen(dayPath.c_str(), "ab"));
+		if (raw)
+		{
+			fwrite(&header, sizeof(header), 1, raw.get());
+			fwrite(words.data(), sizeof(uint64_t), words.size(), raw.get());
+
+			printf("TimeSeriesStore: Recovered %u %s samples\n", header.count, state.name.c_str());
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::remove(path, ec);
+}
+
+void TimeSeriesStore::writeBucket(SeriesState& state, size_t level, const RollupBucket& bucket)
+{
+	if (! kLevels[level].persisted)
+		return;
+
+	enqueue([this, &state, level, record = serializeBucket(bucket)] {
+		auto& file = state.levels[level].file;
+
+		if (! file)
+			file.reset(fopen(rollupPath(state, level).c_str(), "ab"));
+
+		if (! file)
+			return;
+
+		fwrite(record.data(), record.size(), 1, file.get());
+		fflush(file.get());
+	});
+}
+
+void TimeSeriesStore::loadRollups(SeriesState& state, size_t level, const std::string& path)
+{
+	File file(fopen(path.c_str(), "rb"));
+	if (! file)
+		return;
+
+	uint8_t record[kBucketRecordSize];
+	while (fread(record, sizeof(record), 1, file.get()) == 1)
+		state.levels[level].closed.append(parseBucket(record));
+}
+
+void TimeSeriesStore::pruneDailyFiles(int64_t day)
+{
+	m_prunedDay = day;
+
+	enqueue([this, day] {
+		// Raw files are named <series>-raw-YYYYMMDD.gor, compare the date
+		auto cutoff = dateOf(day - kDailyRetentionDays);
+
+		std::error_code ec;
+		for (auto& entry : std::filesystem::directory_iterator(m_directory, ec))
+		{
+			auto stem = entry.path().stem().string();
+			auto dash = stem.rfind('-');
+
+			if (dash == std::string::npos || stem.size() - dash - 1 != cutoff.size())
+				continue;
+
+			if (stem.compare(dash + 1, std::string::npos, cutoff) < 0)
+				std::filesystem::remove(entry.path(), ec);
+		}
+	});
+}
+
+void TimeSeriesStore::enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard lock(m_writeMutex);
+		m_writeJobs.push_back(std::move(job));
+	}
+
+	m_writeCv.notify_all();
+}
+
+void TimeSeriesStore::drain() const
+{
+	std::unique_lock lock(m_writeMutex);
+	m_writeCv.wait(lock, [this] { return m_writeJobs.empty() && ! m_writing; });
+}
+
+void TimeSeriesStore::writerLoop()
+{
+	std::unique_lock lock(m_writeMutex);
+
+	while (1)
+	{
+		m_writeCv.wait(lock, [this] { return m_stopping || ! m_writeJobs.empty(); });
+
+		// Finish queued writes before stopping so nothing recorded is dropped
+		if (m_writeJobs.empty())
+			return;
+
+		auto job = std::move(m_writeJobs.front());
+		m_writeJobs.pop_front();
+		m_writing = true;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		m_writing = false;
+		m_writeCv.notify_all();
+	}
+}
+
+std::vector<TimeSeriesStore::Point> TimeSeriesStore::range(Series series, int64_t fromMs, int64_t toMs, size_t maxPoints) const
+{
+	auto& state = m_series[static_cast<size_t>(series)];
+
+	// Copy of the open block; anything closed before it is already queued for the day files
+	std::vector<uint64_t> openWords;
+	BlockHeader open = {};
+	{
+		std::lock_guard lock(m_stateMutex);
+
+		auto& block = *state.block;
+		if (block.count() && block.lastTimestamp() >= fromMs && block.firstTimestamp() < toMs)
+		{
+			open = { kBlockMagic, static_cast<uint32_t>(block.count()), block.firstTimestamp(), block.lastTimestamp(), block.bitCount() };
+			openWords = block.words();
+		}
+	}
+
+	// Closed blocks may still be on their way to the day files
+	drain();
+
+	std::vector<Point> points;
+
+	auto decode = [&](const uint64_t* words, size_t bitCount, size_t count)
+	{
+		GorillaDecoder decoder(words, bitCount, count);
+
+		Point point;
+		while (points.size() < maxPoints && decoder.next(point.timestampMs, point.value))
+		{
+			if (point.timestampMs >= fromMs && point.timestampMs < toMs)
+				points.push_back(point);
+		}
+	};
+
+	std::vector<uint64_t> words;
+
+	for (auto day = dayOf(fromMs); day <= dayOf(toMs - 1) && points.size() < maxPoints; ++day)
+	{
+		File file(fopen(rawPath(state, day).c_str(), "rb"));
+		if (! file)
+			continue;
+
+		BlockHeader header;
+		while (points.size() < maxPoints && fread(&header, sizeof(header), 1, file.get()) == 1 && header.magic == kBlockMagic)
+		{
+			auto wordCount = (header.bitCount + 63) / 64;
+
+			// The copied block may have closed and been written since
+			if (header.lastMs < fromMs || header.firstMs >= toMs || (open.count && header.firstMs == open.firstMs))
+			{
+				fseek(file.get(), static_cast<long>(wordCount * sizeof(uint64_t)), SEEK_CUR);
+				continue;
+			}
+
+			words.resize(wordCount);
+			if (fread(words.data(), sizeof(uint64_t), wordCount, file.get()) != wordCount)
+				break;
+
+			decode(words.data(), header.bitCount, header.count);
+		}
+	}
+
+	if (open.count)
+		decode(openWords.data(), open.bitCount, open.count);
+
+	std::stable_sort(points.begin(), points.end(), [](const Point& a, const Point& b) { return a.timestampMs < b.timestampMs; });
+
+	return points;
+}
+
+std::vector<RollupBucket> TimeSeriesStore::buckets(Series series, Resolution resolution, int64_t fromMs, int64_t toMs, size_t maxBuckets) const
+{
+	std::lock_guard lock(m_stateMutex);
+
+	auto& state = m_series[static_cast<size_t>(series)];
+	auto& closed = state.levels[static_cast<size_t>(resolution)].closed;
+	auto [first, last] = closed.indexRange(fromMs, toMs);
+
+	std::vector<RollupBucket> buckets;
+
+	for (auto i = first; i < last && buckets.size() < maxBuckets; ++i)
+		buckets.push_back(closed.bucket(i));
+
+	// The current bucket is still open but is where the latest samples are
+	for (auto& bucket : collectOpenBuckets(state, resolution))
+	{
+		if (bucket.startMs >= fromMs && bucket.startMs < toMs && buckets.size() < maxBuckets)
+			buckets.push_back(bucket);
+	}
+
+	return buckets;
+}
+
+RollupAggregate TimeSeriesStore::aggregate(Series series, int64_t fromMs, int64_t toMs, Resolution resolution) const
+{
+	std::lock_guard lock(m_stateMutex);
+
+	auto& state = m_series[static_cast<size_t>(series)];
+	auto result = state.levels[static_cast<size_t>(resolution)].closed.aggregate(fromMs, toMs);
+
+	for (auto& bucket : collectOpenBuckets(state, resolution))
+	{
+		if (bucket.startMs < fromMs || bucket.startMs >= toMs)
+			continue;
+
+		auto sum = static_cast<double>(result.mean) * result.count + bucket.sum;
+
+		result.min = result.count ? std::min(result.min, bucket.min) : bucket.min;
+		result.max = result.count ? std::max(result.max, bucket.max) : bucket.max;
+		result.count += bucket.count;
+		result.mean = static_cast<float>(sum / result.count);
+	}
+
+	return result;
+}
+
+std::vector<RollupBucket> TimeSeriesStore::openBuckets(Series series, Resolution resolution) const
+{
+	std::lock_guard lock(m_stateMutex);
+	return collectOpenBuckets(m_series[static_cast<size_t>(series)], resolution);
+}
+
+std::vector<RollupBucket> TimeSeriesStore::collectOpenBuckets(const SeriesState& state, Resolution resolution) const
+{
+	auto widthMs = kLevels[static_cast<size_t>(resolution)].widthMs;
+
+	std::vector<RollupBucket> buckets;
+
+	// Samples not yet rolled up sit in the open buckets of this and every finer level
+	for (size_t level = 0; level <= static_cast<size_t>(resolution); ++level)
+	{
+		auto& open = state.levels[level].open;
+		if (! open.count)
+			continue;
+
+		auto startMs = open.startMs - open.startMs % widthMs;
+
+		auto it = std::find_if(buckets.begin(), buckets.end(), [startMs](const RollupBucket& bucket) { return bucket.startMs == startMs; });
+		if (it == buckets.end())
+			it = buckets.insert(buckets.end(), { startMs, 0.0f, 0.0f, 0.0, 0 });
+
+		merge(*it, open);
+	}
+
+	std::sort(buckets.begin(), buckets.end(), [](const RollupBucket& a, const RollupBucket& b) { return a.startMs < b.startMs; });
+
+	return buckets;
+}
+
+const RollupSeries& TimeSeriesStore::rollup(Series series, Resolution resolution) const
+{
+	return m_series[static_cast<size_t>(series)].levels[static_cast<size_t>(resolution)].closed;
+}
+
+std::string TimeSeriesStore::rawPath(const SeriesState& state, int64_t day) const
+{
+	return m_directory + "/" + state.name + "-raw-" + dateOf(day) + ".gor";
+}
+
+std::string TimeSeriesStore::checkpointPath(const SeriesState& state) const
+{
+	return m_directory + "/" + state.name + "-checkpoint.gor";
+}
+
+std::string TimeSeriesStore::openBucketsPath(const SeriesState& state) const
+{
+	return m_directory + "/" + state.name + "-open.roll";
+}
+
+std::string TimeSeriesStore::rollupPath(const SeriesState& state, size_t level) const
+{
+	return m_directory + "/" + state.name + "-" + kLevels[level].suffix + ".roll";
+}
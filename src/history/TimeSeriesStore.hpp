@@ -0,0 +1,159 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "GorillaCodec.hpp"
+#include "RollupSeries.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Long-term boiler telemetry history on local storage.
+ *
+ * Raw samples are Gorilla-compressed in blocks and appended to one file per
+ * series per day, pruned after kDailyRetentionDays. The open block is
+ * checkpointed every kCheckpointMs and recovered on the next start, so a
+ * crash loses seconds rather than a whole block. Every sample also feeds
+ * 1 s, 1 min and 1 h rollups which are kept in memory for aggregate queries;
+ * the 1 min and 1 h rollups are also appended to files and kept indefinitely.
+ * Their open buckets are checkpointed alongside the block and on every
+ * close, and picked up again on the next start.
+ *
+ * Samples arrive on the main thread; all file writes happen on a writer
+ * thread so the main loop never waits on storage. Queries may run on any
+ * thread: they copy what they need from memory under a lock and read the
+ * day files outside it, so a long query never holds up append().
+ */
+class TimeSeriesStore : public BoilerSampleDelegate
+{
+public:
+	enum class Series
+	{
+		Temperature,
+		Pressure,
+	};
+
+	enum class Resolution
+	{
+		Second,
+		Minute,
+		Hour,
+	};
+
+	struct Point
+	{
+		int64_t	timestampMs;
+		float	value;
+	};
+
+	explicit TimeSeriesStore(const std::string& directory);
+	~TimeSeriesStore();
+
+	void append(Series series, int64_t timestampMs, float value);
+
+	// Raw samples within [fromMs, toMs), in time order; decoding stops once maxPoints are found
+	std::vector<Point> range(Series series, int64_t fromMs, int64_t toMs, size_t maxPoints = SIZE_MAX) const;
+
+	// Closed and open buckets starting within [fromMs, toMs), in time order, at most maxBuckets
+	std::vector<RollupBucket> buckets(Series series, Resolution resolution, int64_t fromMs, int64_t toMs, size_t maxBuckets = SIZE_MAX) const;
+
+	// Buckets starting within [fromMs, toMs), including the ones still open
+	RollupAggregate aggregate(Series series, int64_t fromMs, int64_t toMs, Resolution resolution) const;
+
+	// Closed buckets only; unlike the queries above, main thread only
+	const RollupSeries& rollup(Series series, Resolution resolution) const;
+
+	// Buckets of this resolution not closed yet, in time order; they follow rollup()'s last bucket
+	std::vector<RollupBucket> openBuckets(Series series, Resolution resolution) const;
+
+	// Wall clock time of a steady clock sample timestamp, in ms since the epoch
+	static int64_t wallClockMs(std::chrono::steady_clock::time_point timestamp);
+
+	// BoilerSampleDelegate i/f
+	void onBoilerSample(const BoilerSample& sample) override;
+
+private:
+	static constexpr size_t kSeriesCount = 2;
+	static constexpr size_t kResolutionCount = 3;
+
+	struct FileCloser
+	{
+		void operator()(FILE* file) const	{ if (file) fclose(file); }
+	};
+
+	using File = std::unique_ptr<FILE, FileCloser>;
+
+	struct Level
+	{
+		explicit Level(size_t maxBuckets)
+			: closed(maxBuckets)
+		{ }
+
+		RollupSeries	closed;
+		RollupBucket	open	= {};
+
+		// Writer thread only
+		File			file;
+	};
+
+	struct SeriesState
+	{
+		SeriesState();
+
+		std::string									name;
+		std::unique_ptr<GorillaEncoder>				block;
+		int64_t										checkpointMs = 0;
+		std::array<Level, kResolutionCount>			levels;
+
+		// Writer thread only
+		File										rawFile;
+		int64_t										rawDay = -1;
+	};
+
+	void closeBlock(SeriesState& state);
+	void checkpointBlock(SeriesState& state);
+	void recoverCheckpoint(SeriesState& state);
+	void checkpointOpenBuckets(SeriesState& state);
+	void recoverOpenBuckets(SeriesState& state);
+	void addToLevel(SeriesState& state, size_t level, const RollupBucket& bucket);
+	void writeBucket(SeriesState& state, size_t level, const RollupBucket& bucket);
+
+	std::vector<RollupBucket> collectOpenBuckets(const SeriesState& state, Resolution resolution) const;
+
+	void loadRollups(SeriesState& state, size_t level, const std::string& path);
+	void pruneDailyFiles(int64_t day);
+
+	// Runs file I/O on the writer thread, in order
+	void enqueue(std::function<void()> job);
+	// Waits until everything queued so far is written
+	void drain() const;
+	void writerLoop();
+
+	std::string rawPath(const SeriesState& state, int64_t day) const;
+	std::string checkpointPath(const SeriesState& state) const;
+	std::string openBucketsPath(const SeriesState& state) const;
+	std::string rollupPath(const SeriesState& state, size_t level) const;
+
+	const std::string						m_directory;
+	std::array<SeriesState, kSeriesCount>	m_series;
+	int64_t									m_prunedDay = -1;
+
+	// Guards the blocks and rollup levels against queries from other threads
+	mutable std::mutex						m_stateMutex;
+
+	std::thread								m_writer;
+	mutable std::mutex						m_writeMutex;
+	mutable std::condition_variable			m_writeCv;
+	std::deque<std::function<void()>>		m_writeJobs;
+	bool									m_writing = false;
+	bool									m_stopping = false;
+};
@@ -0,0 +1,229 @@
+#include "EvdevInput.hpp"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace
+{
+	// A drag produces a sample per touch controller scan; past this, moves are coalesced
+	constexpr size_t kMaxQueued = 256;
+
+	constexpr size_t kMaxWaitInputs = 8;
+
+	uint32_t keypadKey(uint16_t code)
+	{
+		switch (code)
+		{
+		case KEY_BACKSPACE:		return LV_KEY_BACKSPACE;
+		case KEY_ENTER:			return LV_KEY_ENTER;
+		case KEY_PREVIOUS:		return LV_KEY_PREV;
+		case KEY_NEXT:			return LV_KEY_NEXT;
+		case KEY_TAB:			return LV_KEY_NEXT;
+		case KEY_UP:			return LV_KEY_UP;
+		case KEY_DOWN:			return LV_KEY_DOWN;
+		case KEY_LEFT:			return LV_KEY_LEFT;
+		case KEY_RIGHT:			return LV_KEY_RIGHT;
+		default:				return 0;
+		}
+	}
+}
+
+EvdevInput::EvdevInput(lv_indev_type_t type)
+	: m_type(type)
+{
+	m_pending.state = LV_INDEV_STATE_RELEASED;
+	m_last.state = LV_INDEV_STATE_RELEASED;
+}
+
+EvdevInput::~EvdevInput()
+{
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+bool EvdevInput::open(const char* path)
+{
+	m_fd = ::open(path, O_RDONLY | O_NONBLOCK);
+	if (m_fd < 0)
+	{
+		printf("EvdevInput: Unable to open %s\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+void EvdevInput::adopt(int fd)
+{
+	if (m_fd >= 0)
+		close(m_fd);
+
+	m_fd = fd;
+}
+
+lv_indev_t* EvdevInput::registerIndev()
+{
+	lv_indev_drv_init(&m_drv);
+	m_drv.type = m_type;
+	m_drv.read_cb = &EvdevInput::readCb;
+	m_drv.user_data = this;
+
+	m_indev = lv_indev_drv_register(&m_drv);
+
+	return m_indev;
+}
+
+void EvdevInput::registerDelegate(EvdevInputDelegate* delegate)
+{
+	m_delegates.emplace(delegate);
+}
+
+void EvdevInput::deregisterDelegate(EvdevInputDelegate* delegate)
+{
+	if (auto it = m_delegates.find(delegate); it != m_delegates.end())
+		m_delegates.erase(it);
+}
+
+void EvdevInput::process()
+{
+	if (! drain() || ! m_indev)
+		return;
+
+	for (auto delegate : m_delegates)
+		delegate->onInputEvents(*this);
+
+	lv_indev_read_timer_cb(m_indev->driver->read_timer);
+
+	for (auto delegate : m_delegates)
+		delegate->onInputProcessed(*this);
+
+	// Draw the response on this pass rather than at the next refresh period
+	if (auto disp = m_indev->driver->disp)
+		lv_timer_ready(_lv_disp_get_refr_timer(disp));
+}
+
+void EvdevInput::wait(std::initializer_list<EvdevInput*> inputs, int timeoutMs)
+{
+	pollfd fds[kMaxWaitInputs];
+	EvdevInput* ready[kMaxWaitInputs];
+	nfds_t count = 0;
+
+	for (auto input : inputs)
+	{
+		if (input->m_fd < 0 || count == kMaxWaitInputs)
+			continue;
+
+		fds[count] = { input->m_fd, POLLIN, 0 };
+		ready[count] = input;
+		count++;
+	}
+
+	if (poll(fds, count, timeoutMs) <= 0)
+		return;
+
+	for (nfds_t i = 0; i < count; ++i)
+	{
+		if (fds[i].revents & POLLIN)
+			ready[i]->process();
+	}
+}
+
+void EvdevInput::readCb(lv_indev_drv_t* drv, lv_indev_data_t* data)
+{
+	auto input = static_cast<EvdevInput*>(drv->user_data);
+
+	if (! input->m_queue.empty())
+	{
+		input->m_last = input->m_queue.front();
+		input->m_queue.pop_front();
+	}
+
+	data->point = input->m_last.point;
+	data->state = input->m_last.state;
+	data->key = input->m_last.key;
+	data->continue_reading = ! input->m_queue.empty();
+}
+
+bool EvdevInput::drain()
+{
+	input_event events[64];
+	auto queued = m_queue.size();
+
+	while (1)
+	{
+		auto bytes = read(m_fd, events, sizeof(events));
+		if (bytes <= 0)
+			break;
+
+		auto count = static_cast<size_t>(bytes) / sizeof(input_event);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto& event = events[i];
+
+			if (event.type == EV_SYN)
+			{
+				// The kernel dropped events; ignore the rest of the broken frame
+				if (event.code == SYN_DROPPED)
+					m_dropping = true;
+				else if (event.code == SYN_REPORT && m_dropping)
+					m_dropping = false;
+				else if (event.code == SYN_REPORT && m_type == LV_INDEV_TYPE_POINTER)
+					push(m_pending);
+
+				continue;
+			}
+
+			if (m_dropping)
+				continue;
+
+			if (event.type == EV_ABS)
+			{
+				if (event.code == ABS_X || event.code == ABS_MT_POSITION_X)
+					m_pending.point.x = event.value;
+				else if (event.code == ABS_Y || event.code == ABS_MT_POSITION_Y)
+					m_pending.point.y = event.value;
+				else if (event.code == ABS_MT_TRACKING_ID)
+					m_pending.state = event.value == -1 ? LV_INDEV_STATE_RELEASED : LV_INDEV_STATE_PRESSED;
+			}
+			else if (event.type == EV_REL)
+			{
+				if (event.code == REL_X)
+					m_pending.point.x += event.value;
+				else if (event.code == REL_Y)
+					m_pending.point.y += event.value;
+			}
+			else if (event.type == EV_KEY)
+			{
+				if (event.code == BTN_TOUCH || event.code == BTN_MOUSE)
+				{
+					m_pending.state = event.value ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+				}
+				else if (m_type == LV_INDEV_TYPE_KEYPAD && keypadKey(event.code))
+				{
+					// Auto-repeat (value 2) counts as held; keys LVGL has no use for are skipped
+					m_pending.key = keypadKey(event.code);
+					m_pending.state = event.value ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+					push(m_pending);
+				}
+			}
+		}
+	}
+
+	return m_queue.size() != queued;
+}
+
+void EvdevInput::push(const Sample& sample)
+{
+	// Merge into the newest sample only when it is the same press state, so presses and releases are never lost
+	if (m_queue.size() >= kMaxQueued && m_queue.back().state == sample.state)
+	{
+		m_queue.back() = sample;
+		return;
+	}
+
+	m_queue.push_back(sample);
+}
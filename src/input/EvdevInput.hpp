@@ -0,0 +1,87 @@
+#pragma once
+
+#include "lvgl.h"
+
+#include <deque>
+#include <initializer_list>
+#include <set>
+
+class EvdevInput;
+
+class EvdevInputDelegate
+{
+public:
+	// Called with new events queued, before LVGL reads them
+	virtual void onInputEvents(EvdevInput& input)	{ };
+
+	// Called once LVGL has read and acted on them, before the response is drawn
+	virtual void onInputProcessed(EvdevInput& input)	{ };
+};
+
+/**
+ * LVGL input device reading a Linux evdev node on demand.
+ *
+ * Instead of LVGL polling the device every read period, the main loop
+ * waits on the device fds (see wait()) and a ready device is read straight
+ * away. Every queued kernel event is drained per wake and each complete
+ * sample (one SYN_REPORT for pointers, one key event for keypads) is handed
+ * to LVGL in order using continue_reading, so drags keep every
+ * intermediate position instead of only the last one.
+ *
+ * LVGL's read timer keeps running for long press and repeat detection.
+ */
+class EvdevInput
+{
+public:
+	explicit EvdevInput(lv_indev_type_t type);
+	~EvdevInput();
+
+	EvdevInput(const EvdevInput&) = delete;
+	EvdevInput& operator=(const EvdevInput&) = delete;
+
+	bool open(const char* path);
+
+	// Reads an already open descriptor instead, such as a pipe of recorded events; takes ownership
+	void adopt(int fd);
+	lv_indev_t* registerIndev();
+
+	void registerDelegate(EvdevInputDelegate* delegate);
+	void deregisterDelegate(EvdevInputDelegate* delegate);
+
+	int fd() const				{ return m_fd; }
+	lv_indev_t* indev() const	{ return m_indev; }
+
+	// Reads everything queued on the fd and passes it to LVGL
+	void process();
+
+	// Waits up to timeoutMs for any of the inputs to become readable and processes those that are
+	static void wait(std::initializer_list<EvdevInput*> inputs, int timeoutMs);
+
+private:
+	struct Sample
+	{
+		lv_point_t			point;
+		lv_indev_state_t	state;
+		uint32_t			key;
+	};
+
+	static void readCb(lv_indev_drv_t* drv, lv_indev_data_t* data);
+
+	bool drain();
+	void push(const Sample& sample);
+
+	const lv_indev_type_t		m_type;
+	int							m_fd = -1;
+
+	lv_indev_drv_t				m_drv;
+	lv_indev_t*					m_indev = nullptr;
+
+	// Sample being assembled from the current event frame
+	Sample						m_pending = {};
+	bool						m_dropping = false;
+
+	std::deque<Sample>			m_queue;
+	Sample						m_last = {};
+
+	std::set<EvdevInputDelegate*>	m_delegates;
+};
@@ -0,0 +1,335 @@
+#include "TouchLatencyBenchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <set>
+#include <unistd.h>
+
+namespace
+{
+	constexpr auto kResponseTimeout = std::chrono::milliseconds(500);
+
+	// Pause between passes so the last response settles before the next press
+	constexpr auto kPassGap = std::chrono::milliseconds(1000);
+
+	// Raw touch units a press may wander and still count as a tap
+	constexpr int kDragThreshold = 16;
+
+	TouchLatencyBenchmark* s_active = nullptr;
+
+	uint32_t areaSize(const lv_area_t& area)
+	{
+		return static_cast<uint32_t>(lv_area_get_size(&area));
+	}
+
+	double percentile(const std::vector<double>& sorted, double p)
+	{
+		auto index = static_cast<size_t>(std::lround(p * (sorted.size() - 1)));
+		return sorted[index];
+	}
+}
+
+std::vector<input_event> TouchLatencyBenchmark::load(const char* path)
+{
+	std::vector<input_event> events;
+
+	auto file = fopen(path, "rb");
+	if (! file)
+		return events;
+
+	input_event event;
+	while (fread(&event, sizeof(event), 1, file) == 1)
+		events.push_back(event);
+
+	fclose(file);
+
+	// Drop a trailing partial frame
+	while (! events.empty() && ! (events.back().type == EV_SYN && events.back().code == SYN_REPORT))
+		events.pop_back();
+
+	return events;
+}
+
+TouchLatencyBenchmark::TouchLatencyBenchmark(const std::vector<input_event>& recording, int repeats)
+	: m_repeats(repeats < 1 ? 1 : repeats)
+{
+	int fds[2];
+	if (pipe2(fds, O_NONBLOCK) == 0)
+	{
+		m_readFd = fds[0];
+		m_writeFd = fds[1];
+	}
+
+	auto toDuration = [](const timeval& time)
+	{
+		return std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec);
+	};
+
+	// Split into frames and work out each frame's phase
+	Frame frame;
+	bool pressed = false;
+	size_t gestureStart = 0;
+	int x = 0, y = 0, pressX = 0, pressY = 0;
+	bool dragged = false;
+	auto start = recording.empty() ? Clock::duration() : Clock::duration(toDuration(recording.front().time));
+
+	for (auto& event : recording)
+	{
+		frame.events.push_back(event);
+
+		if (event.type == EV_ABS && (event.code == ABS_X || event.code == ABS_MT_POSITION_X))
+			x = event.value;
+		else if (event.type == EV_ABS && (event.code == ABS_Y || event.code == ABS_MT_POSITION_Y))
+			y = event.value;
+
+		auto down = (event.type == EV_KEY && event.code == BTN_TOUCH && event.value)
+			|| (event.type == EV_ABS && event.code == ABS_MT_TRACKING_ID && event.value != -1);
+		auto up = (event.type == EV_KEY && event.code == BTN_TOUCH && ! event.value)
+			|| (event.type == EV_ABS && event.code == ABS_MT_TRACKING_ID && event.value == -1);
+
+		if (down && ! pressed)
+			frame.type = "press";
+		else if (up && pressed)
+			frame.type = "release";
+
+		if (event.type != EV_SYN || event.code != SYN_REPORT)
+			continue;
+
+		if (frame.type == "press")
+		{
+			pressed = true;
+			gestureStart = m_frames.size();
+			pressX = x;
+			pressY = y;
+			dragged = false;
+		}
+		else if (frame.type.empty() && pressed)
+		{
+			frame.type = "move";
+			dragged = dragged || std::abs(x - pressX) > kDragThreshold || std::abs(y - pressY) > kDragThreshold;
+		}
+
+		frame.offset = toDuration(event.time) - start;
+		m_frames.push_back(std::move(frame));
+		frame = {};
+
+		if (m_frames.back().type == "release")
+		{
+			pressed = false;
+
+			for (auto i = gestureStart; i < m_frames.size(); ++i)
+				m_frames[i].type = (dragged ? "drag/" : "tap/") + m_frames[i].type;
+		}
+	}
+}
+
+TouchLatencyBenchmark::~TouchLatencyBenchmark()
+{
+	if (m_drv && s_active == this)
+	{
+		m_drv->flush_cb = m_flushCb;
+		s_active = nullptr;
+	}
+
+	if (m_readFd >= 0)
+		close(m_readFd);
+
+	if (m_writeFd >= 0)
+		close(m_writeFd);
+}
+
+int TouchLatencyBenchmark::takeInputFd()
+{
+	auto fd = m_readFd;
+	m_readFd = -1;
+
+	return fd;
+}
+
+void TouchLatencyBenchmark::attach(lv_disp_t* disp)
+{
+	m_drv = disp->driver;
+	m_flushCb = m_drv->flush_cb;
+	m_drv->flush_cb = &TouchLatencyBenchmark::flushCb;
+	s_active = this;
+}
+
+void TouchLatencyBenchmark::tick()
+{
+	auto now = Clock::now();
+
+	if (! m_started)
+	{
+		m_started = true;
+		m_passStart = now;
+	}
+
+	while (m_pass < m_repeats && m_next < m_frames.size() && now - m_passStart >= m_frames[m_next].offset)
+	{
+		auto& frame = m_frames[m_next++];
+
+		if (write(m_writeFd, frame.events.data(), frame.events.size() * sizeof(input_event)) < 0)
+			printf("TouchLatencyBenchmark: Injection pipe is full\n");
+
+		// Frames outside a gesture (e.g. stray position updates) are injected but not measured
+		if (! frame.type.empty())
+		{
+			std::lock_guard lock(m_mutex);
+			m_pending.push_back({ &frame, Clock::now(), false, {}, 0 });
+		}
+
+		if (m_next == m_frames.size())
+		{
+			m_pass++;
+			m_next = 0;
+			m_passStart = now + kPassGap;
+		}
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	while (! m_pending.empty() && now - m_pending.front().injected > kResponseTimeout)
+	{
+		m_unanswered[m_pending.front().frame->type]++;
+		m_pending.pop_front();
+	}
+}
+
+bool TouchLatencyBenchmark::finished() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_pass >= m_repeats && m_pending.empty();
+}
+
+void TouchLatencyBenchmark::onInputProcessed(EvdevInput& input)
+{
+	auto disp = lv_disp_get_default();
+
+	lv_point_t point;
+	lv_indev_get_point(input.indev(), &point);
+
+	// Searched the way LVGL searches for the pressed object
+	auto target = lv_indev_search_obj(lv_layer_top(), &point);
+	if (! target)
+		target = lv_indev_search_obj(lv_disp_get_scr_act(disp), &point);
+
+	lv_area_t targetArea;
+	if (target)
+		lv_obj_get_coords(target, &targetArea);
+	else
+		lv_area_set(&targetArea, 0, 0, lv_disp_get_hor_res(disp) - 1, lv_disp_get_ver_res(disp) - 1);
+
+	// What the input invalidated on the target, drawn on this pass
+	std::vector<lv_area_t> expected;
+	for (uint16_t i = 0; i < disp->inv_p; ++i)
+	{
+		lv_area_t area;
+		if (_lv_area_intersect(&area, &disp->inv_areas[i], &targetArea))
+			expected.push_back(area);
+	}
+
+	// Nothing yet, e.g. a transition that starts on a later tick: any redraw of the target counts
+	if (expected.empty())
+		expected.push_back(targetArea);
+
+	uint32_t size = 0;
+	for (auto& area : expected)
+		size += areaSize(area);
+
+	std::lock_guard lock(m_mutex);
+
+	// LVGL has read everything that was queued, so these are all answered by this target
+	for (auto& pending : m_pending)
+	{
+		if (pending.read)
+			continue;
+
+		pending.read = true;
+		pending.expected = expected;
+		pending.remaining = size;
+	}
+}
+
+void TouchLatencyBenchmark::onAreaPresented(const lv_area_t& area)
+{
+	auto now = Clock::now();
+
+	std::lock_guard lock(m_mutex);
+
+	for (auto it = m_pending.begin(); it != m_pending.end(); )
+	{
+		if (! it->read)
+		{
+			++it;
+			continue;
+		}
+
+		for (auto& expected : it->expected)
+		{
+			lv_area_t covered;
+			if (_lv_area_intersect(&covered, &area, &expected))
+				it->remaining -= std::min(it->remaining, areaSize(covered));
+		}
+
+		if (it->remaining)
+		{
+			++it;
+			continue;
+		}
+
+		m_latencies[it->frame->type].push_back(std::chrono::duration<double, std::milli>(now - it->injected).count());
+		it = m_pending.erase(it);
+	}
+}
+
+void TouchLatencyBenchmark::flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+	if (s_active)
+	{
+		// The driver has drawn the area once its flush_cb returns
+		auto presented = *area;
+
+		s_active->m_flushCb(drv, area, color_p);
+		s_active->onAreaPresented(presented);
+	}
+}
+
+void TouchLatencyBenchmark::printSummary() const
+{
+	std::lock_guard lock(m_mutex);
+
+	printf("Touch latency -- %zu frames x %d passes\n", m_frames.size(), m_repeats);
+
+	std::set<std::string> types;
+	for (auto& [type, latencies] : m_latencies)
+		types.insert(type);
+	for (auto& [type, count] : m_unanswered)
+		types.insert(type);
+
+	for (auto& type : types)
+	{
+		auto unanswered = m_unanswered.count(type) ? m_unanswered.at(type) : 0;
+		auto latencies = m_latencies.count(type) ? m_latencies.at(type) : std::vector<double>();
+
+		if (latencies.empty())
+		{
+			printf("%-14s      0 responses, %u with no visible change\n", type.c_str(), unanswered);
+			continue;
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+
+		printf("%-14s %6zu responses: min %.1fms, p50 %.1fms, p90 %.1fms, p99 %.1fms, max %.1fms, %u with no visible change\n",
+			   type.c_str(),
+			   latencies.size(),
+			   latencies.front(),
+			   percentile(latencies, 0.50),
+			   percentile(latencies, 0.90),
+			   percentile(latencies, 0.99),
+			   latencies.back(),
+			   unanswered);
+	}
+}
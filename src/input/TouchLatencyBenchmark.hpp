@@ -0,0 +1,116 @@
+#pragma once
+
+#include "EvdevInput.hpp"
+#include "FramebufferDisplay.hpp"
+
+#include "lvgl.h"
+
+#include <linux/input.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Touch-to-photon latency of the UI, measured by replaying a recorded
+ * touchscreen session through the real input path.
+ *
+ * The recording is the raw evdev stream of the touchscreen, e.g.
+ *   cat /dev/input/by-path/platform-fe205000.i2c-event > taps.evdev
+ * Each SYN_REPORT frame is written, at its recorded time, into a pipe that
+ * the touchscreen EvdevInput reads in place of the device, so frames go
+ * through the same poll/drain/continue_reading path as real touches.
+ *
+ * A frame is timestamped when it is written. Once LVGL has acted on it, the
+ * object under the touch point is the probe target, and the target's part
+ * of the pending invalidated areas (or the whole target if none) is what
+ * the response must redraw. The frame is answered when presented areas
+ * have covered that, timed when the pixels are on the panel: after the
+ * copy or page flip of FramebufferDisplay, or after a synchronous driver's
+ * flush_cb returns. Frames are classified by gesture (tap or
+ * drag, decided from the whole press-to-release sequence) and phase
+ * (press, move, release), and the latency distribution is reported for
+ * each. Frames with no flush within kResponseTimeout changed nothing on
+ * screen and are counted separately.
+ *
+ * Run without telemetry (as --replay does) so other redraws are not
+ * mistaken for responses.
+ */
+class TouchLatencyBenchmark : public EvdevInputDelegate, public DisplayPresentDelegate
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Empty if the file holds no complete frames
+	static std::vector<input_event> load(const char* path);
+
+	TouchLatencyBenchmark(const std::vector<input_event>& recording, int repeats);
+	~TouchLatencyBenchmark();
+
+	TouchLatencyBenchmark(const TouchLatencyBenchmark&) = delete;
+	TouchLatencyBenchmark& operator=(const TouchLatencyBenchmark&) = delete;
+
+	// Read end of the injection pipe, for EvdevInput::adopt(); ownership passes to the caller
+	int takeInputFd();
+
+	// For drivers whose flush_cb has drawn the area by the time it returns, e.g.
+	// fbdev; wraps the flush_cb, one benchmark at a time. FramebufferDisplay
+	// reports through setPresentDelegate() instead.
+	void attach(lv_disp_t* disp);
+
+	// Writes the frames that are due and expires unanswered ones
+	void tick();
+
+	bool finished() const;
+	void printSummary() const;
+
+	// EvdevInputDelegate i/f
+	void onInputProcessed(EvdevInput& input) override;
+
+	// DisplayPresentDelegate i/f; may be called on the display's flush thread
+	void onAreaPresented(const lv_area_t& area) override;
+
+private:
+	struct Frame
+	{
+		Clock::duration				offset;
+		std::vector<input_event>	events;
+		std::string					type;
+	};
+
+	struct Pending
+	{
+		const Frame*			frame;
+		Clock::time_point		injected;
+		bool					read;
+
+		// The probe target's part of the invalidated areas, and how much of it is still to be presented
+		std::vector<lv_area_t>	expected;
+		uint32_t				remaining;
+	};
+
+	static void flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+
+	std::vector<Frame>						m_frames;
+	int										m_repeats;
+
+	int										m_readFd = -1;
+	int										m_writeFd = -1;
+
+	lv_disp_drv_t*							m_drv = nullptr;
+	void									(*m_flushCb)(lv_disp_drv_t*, const lv_area_t*, lv_color_t*) = nullptr;
+
+	bool									m_started = false;
+	Clock::time_point						m_passStart;
+	int										m_pass = 0;
+	size_t									m_next = 0;
+
+	// Guards the pending frames and results, which presents may update from the flush thread
+	mutable std::mutex						m_mutex;
+	std::deque<Pending>						m_pending;
+	std::map<std::string, std::vector<double>>	m_latencies;	// ms
+	std::map<std::string, uint32_t>			m_unanswered;
+};
@@ -9,41 +9,109 @@
  *********************/
 #include "lvgl.h"
 #include "lv_drivers/display/fbdev.h"
-#include "lv_drivers/indev/evdev.h"
-#include "lv_drivers/indev/evdev2.h"
 
+#include <algorithm>
 #include <fcntl.h>
+#include <memory>
 #include <netdb.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <linux/kd.h>
 #include <linux/vt.h>
 #include <sys/ioctl.h>
 
+#include "EvdevInput.hpp"
+#include "FramebufferDisplay.hpp"
+#include "ParallelRenderer.hpp"
+#include "RefreshGovernor.hpp"
 #include "EspressoUI.hpp"
 #include "EspressoConnectionScreen.hpp"
+#include "BrewByWeight.hpp"
+#include "PressureProfileExecutor.hpp"
+#include "ShotLog.hpp"
+#include "ShotSession.hpp"
+#include "ShotTimerOverlay.hpp"
+#include "StabilityIndicator.hpp"
+#include "TemperatureStability.hpp"
+#include "ShotRecorder.hpp"
+#include "TelemetryReplay.hpp"
+#include "TouchLatencyBenchmark.hpp"
+#include "TelemetryServer.hpp"
+#include "HealthAlertBanner.hpp"
+#include "HealthMonitor.hpp"
+#include "DeviceRegistry.hpp"
+#include "MachineOverviewScreen.hpp"
+#include "TimeSeriesStore.hpp"
 
 #define DISP_BUF_SIZE (800 * 480)
 
-static void hal_init();
+static void hal_init(FramebufferDisplay* framebuffer, ParallelRenderer* renderer);
 static void timer_init();
+static void waitForInput(uint32_t timeUntilNext);
 static std::string resolveURL(const char* hostname);
+static int runReplay(const char* path, float speed);
+static int runDashboard(const char* path);
+static int runTouchLatency(FramebufferDisplay* framebuffer, const char* path, int repeats);
 
 namespace
 {
 	const char* kHostnameCore = "coffee.local";
 	const char* kHostnameScales = "espresso-scales.local";
 	char* kTouchscreenEvDev = "/dev/input/by-path/platform-fe205000.i2c-event";
+	const char* kFramebufferDevice = "/dev/fb0";
+	const size_t kRenderBands = 4;
+	const char* kBacklightPower = "/sys/class/backlight/rpi_backlight/bl_power";
+	const uint32_t kMaxLoopWait = 1;	// ms
 	char* kKeyboardEvDev = "/dev/input/by-path/platform-fd500000.pcie-pci-0000:01:00.0-usb-0:1.2:1.0-event-kbd";
+	const char* kShotRecorderPath = "espresso-telemetry.ring";
+	const uint32_t kShotRecorderCapacity = 1 << 18;
+	const char* kHistoryPath = "history";
+	const char* kShotLogPath = "shots.csv";
+	const auto kStabilityShortWindow = std::chrono::seconds(10);
+	const auto kStabilityLongWindow = std::chrono::seconds(60);
+	const size_t kStabilityCapacity = 4096;
+	const size_t kPollThreads = 4;
+	const auto kResolverTtl = std::chrono::minutes(5);
+	const char* kTelemetryServerHost = "127.0.0.1";
+	const char* kTelemetryServerLanHost = "0.0.0.0";	// only with an API token
+	const char* kTelemetryTokenEnv = "ESPRESSO_API_TOKEN";
+	const int kTelemetryServerPort = 8080;
 }
 
-int main(int, char**)
+static EvdevInput touchInput(LV_INDEV_TYPE_POINTER);
+static EvdevInput keyboardInput(LV_INDEV_TYPE_KEYPAD);
+
+int main(int argc, char** argv)
 {
 	/*Initialize LVGL*/
 	lv_init();
 
-	/*Linux frame buffer device init*/
-	fbdev_init();
+	// --direct-fb: render into a double-buffered framebuffer and page flip (panel rotated by firmware)
+	// --parallel-render: blend large areas in bands across the cores
+	static FramebufferDisplay framebuffer;
+	auto framebufferMode = FramebufferDisplay::Mode::RotateCopy;
+	std::unique_ptr<ParallelRenderer> renderer;
+
+	while (argc > 1)
+	{
+		if (strcmp(argv[1], "--direct-fb") == 0)
+			framebufferMode = FramebufferDisplay::Mode::PageFlip;
+		else if (strcmp(argv[1], "--parallel-render") == 0)
+			renderer = std::make_unique<ParallelRenderer>(kRenderBands);
+		else
+			break;
+
+		argc--;
+		argv++;
+	}
+
+	auto framebufferReady = framebuffer.open(kFramebufferDevice, framebufferMode)
+		|| (framebufferMode != FramebufferDisplay::Mode::RotateCopy && framebuffer.open(kFramebufferDevice, FramebufferDisplay::Mode::RotateCopy));
+
+	/*Linux frame buffer device init, if the framebuffer could not be set up at LVGL's colour depth*/
+	if (! framebufferReady)
+		fbdev_init();
 
 	if (auto fd = open("/dev/tty0", O_RDWR | O_SYNC); fd < 0) {
 		return -1;
@@ -56,21 +124,51 @@ int main(int, char**)
 	if (auto fd = open(kTouchscreenEvDev, O_RDWR); fd < 0)
 		return -1;
 
-	hal_init();
+	hal_init(framebufferReady ? &framebuffer : nullptr, renderer.get());
 	timer_init();
 
 	auto& settings = SettingsManager::get();
 	settings.load();
 
+	// --replay <file> [speed]: play back a recorded session instead of polling
+	if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+		return runReplay(argv[2], argc > 3 ? atof(argv[3]) : 1.0f);
+
+	// --touch-latency <recording> [repeats]: replay recorded touches and report touch-to-photon latency
+	if (argc > 2 && strcmp(argv[1], "--touch-latency") == 0)
+		return runTouchLatency(framebufferReady ? &framebuffer : nullptr, argv[2], argc > 3 ? atoi(argv[3]) : 1);
+
+	// --machines <file>: overview of several machines instead of the single machine UI
+	if (argc > 2 && strcmp(argv[1], "--machines") == 0)
+		return runDashboard(argv[2]);
+
 	auto resolveFut = std::async(&resolveURL, kHostnameCore);
 	auto resolveScalesFut = std::async(&resolveURL, kHostnameScales);
 
 	std::unique_ptr<BoilerController>	boiler;
 	std::unique_ptr<ScalesController>	scales;
 	std::unique_ptr<EspressoUI>			ui;
+	std::unique_ptr<BrewByWeight>		brewByWeight;
+	std::unique_ptr<PressureProfileExecutor>	pressureProfile;
+	std::unique_ptr<ShotSession>		shotSession;
+	std::unique_ptr<ShotTimerOverlay>	shotTimer;
+	std::unique_ptr<StabilityIndicator>	stabilityIndicator;
+	std::unique_ptr<ShotLog>			shotLog;
+	std::unique_ptr<TelemetryServer>	telemetryServer;
+	std::unique_ptr<HealthAlertBanner>	healthBanner;
+
+	ShotRecorder recorder(kShotRecorderPath, kShotRecorderCapacity);
+	TimeSeriesStore history(kHistoryPath);
+	TemperatureStability stability(kStabilityShortWindow, kStabilityLongWindow, kStabilityCapacity);
+	HealthMonitor boilerHealth(kHostnameCore);
+	HealthMonitor scalesHealth(kHostnameScales);
 
 	EspressoConnectionScreen connectionScreen(kHostnameCore);
 
+	RefreshGovernor governor(lv_disp_get_default(), kBacklightPower);
+	touchInput.registerDelegate(&governor);
+	keyboardInput.registerDelegate(&governor);
+
 	bool pendingResolve = true;
 
 	printf("Starting ESPresso-Client, resolving %s...\n", kHostnameCore);
@@ -78,8 +176,7 @@ int main(int, char**)
 	/*Handle LitlevGL tasks (tickless mode)*/
 	while (1)
 	{
-		lv_timer_handler();
-		usleep(500);
+		waitForInput(lv_timer_handler());
 
 		if (boiler)
 			boiler->tick();
@@ -87,6 +184,14 @@ int main(int, char**)
 		if (scales)
 			scales->tick();
 
+		if (shotSession)
+			shotSession->tick();
+
+		if (telemetryServer)
+			telemetryServer->tick();
+
+		governor.tick();
+
 		if (pendingResolve)
 		{
 			if (lv_tick_get() < 4700 || resolveFut.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
@@ -107,6 +212,45 @@ int main(int, char**)
 
 			ui->init(boiler.get(), scales.get());
 
+			boiler->registerHealthDelegate(&boilerHealth);
+			scales->registerHealthDelegate(&scalesHealth);
+
+			boiler->registerBoilerSampleDelegate(&recorder);
+			scales->registerSampleDelegate(&recorder);
+			boiler->registerBoilerSampleDelegate(&history);
+			boiler->registerBoilerSampleDelegate(&stability);
+
+			brewByWeight = std::make_unique<BrewByWeight>(*boiler, *scales);
+			pressureProfile = std::make_unique<PressureProfileExecutor>(*boiler, url);
+
+			shotSession = std::make_unique<ShotSession>(*boiler);
+			shotTimer = std::make_unique<ShotTimerOverlay>();
+			shotSession->registerShotTimerDelegate(shotTimer.get());
+
+			stabilityIndicator = std::make_unique<StabilityIndicator>();
+			stability.registerDelegate(stabilityIndicator.get());
+
+			shotLog = std::make_unique<ShotLog>(kShotLogPath, stability);
+			shotSession->registerShotTimerDelegate(shotLog.get());
+			shotSession->registerShotTimerDelegate(&governor);
+
+			telemetryServer = std::make_unique<TelemetryServer>(*boiler, history);
+			boiler->registerBoilerSampleDelegate(telemetryServer.get());
+			scales->registerSampleDelegate(telemetryServer.get());
+			telemetryServer->addHealthMonitor(boilerHealth);
+			telemetryServer->addHealthMonitor(scalesHealth);
+			if (auto token = getenv(kTelemetryTokenEnv); token && *token)
+			{
+				telemetryServer->setApiToken(token);
+				telemetryServer->start(kTelemetryServerLanHost, kTelemetryServerPort);
+			}
+			else
+				telemetryServer->start(kTelemetryServerHost, kTelemetryServerPort);
+
+			healthBanner = std::make_unique<HealthAlertBanner>();
+			boilerHealth.registerDelegate(healthBanner.get());
+			scalesHealth.registerDelegate(healthBanner.get());
+
 			boiler->setBoilerBrewTemp(settings["BrewTemp"].getAs<float>());
 			boiler->setBoilerSteamTemp(settings["SteamTemp"].getAs<float>());
 			boiler->setBoilerBrewPressure(settings["BrewPressure"].getAs<float>());
@@ -124,44 +268,48 @@ int main(int, char**)
  * Initialize the Hardware Abstraction Layer (HAL) for the LVGL graphics
  * library
  */
-static void hal_init()
+static void hal_init(FramebufferDisplay* framebuffer, ParallelRenderer* renderer)
 {
-	/*A small buffer for LittlevGL to draw the screen's content*/
-	static lv_color_t buf[DISP_BUF_SIZE];
-	static lv_color_t buf2[DISP_BUF_SIZE];
-
-	/*Initialize a descriptor for the buffer*/
-	static lv_disp_draw_buf_t disp_buf;
-	lv_disp_draw_buf_init(&disp_buf, buf, buf2, DISP_BUF_SIZE);
-
-	/*Initialize and register a display driver*/
-	static lv_disp_drv_t disp_drv;
-	lv_disp_drv_init(&disp_drv);
-	disp_drv.draw_buf = &disp_buf;
-	disp_drv.flush_cb = fbdev_flush;
-	disp_drv.hor_res = 800;
-	disp_drv.ver_res = 480;
-	disp_drv.sw_rotate=1;
-	lv_disp_drv_register(&disp_drv);
-
-	lv_disp_set_rotation(NULL, LV_DISP_ROT_180);
-
-	evdev_set_file(kTouchscreenEvDev);
-	static lv_indev_drv_t indev_drv_1;
-	lv_indev_drv_init(&indev_drv_1); /*Basic initialization*/
-	indev_drv_1.type = LV_INDEV_TYPE_POINTER;
-
-	/*This function will be called periodically (by the library) to get the mouse position and state*/
-	indev_drv_1.read_cb = evdev_read;
-	lv_indev_t* mouse_indev = lv_indev_drv_register(&indev_drv_1);
-
-	evdev2_set_file(kKeyboardEvDev);
-	static lv_indev_drv_t indev_drv_2;
-	lv_indev_drv_init(&indev_drv_2); /*Basic initialization*/
-	indev_drv_2.type = LV_INDEV_TYPE_KEYPAD;
-
-	indev_drv_2.read_cb = evdev2_read;
-	lv_indev_t* kb_indev = lv_indev_drv_register(&indev_drv_2);
+	if (framebuffer)
+	{
+		framebuffer->registerDisplay(renderer);
+	}
+	else
+	{
+		/*Full screen buffers for LittlevGL to draw the screen's content, for the lv_drivers fallback*/
+		static auto buf = std::make_unique<lv_color_t[]>(DISP_BUF_SIZE);
+		static auto buf2 = std::make_unique<lv_color_t[]>(DISP_BUF_SIZE);
+
+		/*Initialize a descriptor for the buffer*/
+		static lv_disp_draw_buf_t disp_buf;
+		lv_disp_draw_buf_init(&disp_buf, buf.get(), buf2.get(), DISP_BUF_SIZE);
+
+		/*Initialize and register a display driver*/
+		static lv_disp_drv_t disp_drv;
+		lv_disp_drv_init(&disp_drv);
+		disp_drv.draw_buf = &disp_buf;
+		disp_drv.flush_cb = fbdev_flush;
+		disp_drv.hor_res = 800;
+		disp_drv.ver_res = 480;
+		disp_drv.sw_rotate=1;
+
+		if (renderer)
+			ParallelRenderer::prepare(&disp_drv);
+
+		auto disp = lv_disp_drv_register(&disp_drv);
+
+		if (renderer)
+			renderer->attach(disp);
+
+		lv_disp_set_rotation(NULL, LV_DISP_ROT_180);
+	}
+
+	/*Touchscreen and keyboard, read as soon as the main loop sees their events*/
+	if (touchInput.open(kTouchscreenEvDev))
+		touchInput.registerIndev();
+
+	if (keyboardInput.open(kKeyboardEvDev))
+		keyboardInput.registerIndev();
 }
 
 void alarmHandler(int sig_num)
@@ -176,6 +324,12 @@ static void timer_init()
 	ualarm(5000, 5000);
 }
 
+static void waitForInput(uint32_t timeUntilNext)
+{
+	// Input wakes the loop at once; otherwise sleep until LVGL or the controllers need it
+	EvdevInput::wait({ &touchInput, &keyboardInput }, static_cast<int>(std::min(timeUntilNext, kMaxLoopWait)));
+}
+
 static std::string resolveURL(const char* hostname)
 {
 	struct hostent* hp = gethostbyname(hostname);
@@ -186,3 +340,134 @@ static std::string resolveURL(const char* hostname)
 	return "http://" + std::string(inet_ntoa(*(struct in_addr*)(hp->h_addr_list[0])));
 }
 
+
+static int runReplay(const char* path, float speed)
+{
+	auto rows = ShotRecorder::load(path);
+	if (rows.empty())
+	{
+		printf("Nothing to replay in %s\n", path);
+		return -1;
+	}
+
+	BoilerController boiler;
+	ScalesController scales;
+	EspressoUI ui;
+
+	ui.init(&boiler, &scales);
+
+	TelemetryReplay replay(std::move(rows), boiler, scales);
+	replay.setSpeed(speed);
+
+	printf("Replaying %s at %.1fx\n", path, speed);
+
+	while (! replay.finished())
+	{
+		replay.tick();
+
+		boiler.tick();
+		scales.tick();
+
+		auto renderStart = std::chrono::steady_clock::now();
+		auto timeUntilNext = lv_timer_handler();
+		replay.recordFrame(std::chrono::steady_clock::now() - renderStart);
+
+		waitForInput(timeUntilNext);
+	}
+
+	replay.printSummary();
+
+	return 0;
+}
+
+static int runTouchLatency(FramebufferDisplay* framebuffer, const char* path, int repeats)
+{
+	auto recording = TouchLatencyBenchmark::load(path);
+	if (recording.empty())
+	{
+		printf("No touch events in %s\n", path);
+		return -1;
+	}
+
+	// Offline controllers, so only the injected touches change the screen
+	BoilerController boiler;
+	ScalesController scales;
+	EspressoUI ui;
+
+	ui.init(&boiler, &scales);
+
+	TouchLatencyBenchmark benchmark(recording, repeats);
+	touchInput.adopt(benchmark.takeInputFd());
+	touchInput.registerDelegate(&benchmark);
+
+	// Responses are timed when they reach the panel, not when they are handed to the driver
+	if (framebuffer)
+		framebuffer->setPresentDelegate(&benchmark);
+	else
+		benchmark.attach(lv_disp_get_default());
+
+	printf("Measuring touch latency with %s, %d passes\n", path, repeats);
+
+	while (! benchmark.finished())
+	{
+		benchmark.tick();
+
+		boiler.tick();
+		scales.tick();
+
+		waitForInput(lv_timer_handler());
+	}
+
+	touchInput.deregisterDelegate(&benchmark);
+
+	if (framebuffer)
+		framebuffer->setPresentDelegate(nullptr);
+
+	benchmark.printSummary();
+
+	return 0;
+}
+
+static int runDashboard(const char* path)
+{
+	auto configs = DeviceRegistry::loadConfig(path);
+	if (configs.empty())
+	{
+		printf("No machines configured in %s\n", path);
+		return -1;
+	}
+
+	PollReactor reactor(kPollThreads);
+	ResolverCache resolver(reactor, kResolverTtl);
+	DeviceRegistry registry(reactor, resolver, kHistoryPath);
+
+	for (auto& config : configs)
+		registry.add(config);
+
+	MachineOverviewScreen overview(registry);
+	overview.show();
+
+	HealthAlertBanner healthBanner;
+
+	for (size_t i = 0; i < registry.size(); ++i)
+	{
+		registry[i].boilerHealth.registerDelegate(&healthBanner);
+		registry[i].scalesHealth.registerDelegate(&healthBanner);
+	}
+
+	RefreshGovernor governor(lv_disp_get_default(), kBacklightPower);
+	touchInput.registerDelegate(&governor);
+	keyboardInput.registerDelegate(&governor);
+
+	printf("Starting ESPresso-Client dashboard for %zu machines\n", registry.size());
+
+	while (1)
+	{
+		waitForInput(lv_timer_handler());
+
+		registry.tick();
+		governor.tick();
+	}
+
+	return 0;
+}
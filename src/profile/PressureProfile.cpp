@@ -0,0 +1,45 @@
+#include "PressureProfile.hpp"
+
+PressureProfile::PressureProfile(const Parameters& parameters)
+{
+	auto t = 0.0f;
+
+	addPoint(t, parameters.preinfusionPressure);
+	addPoint(t += parameters.preinfusionTime, parameters.preinfusionPressure);
+	addPoint(t += parameters.rampTime, parameters.peakPressure);
+	addPoint(t += parameters.peakTime, parameters.peakPressure);
+	addPoint(t += parameters.declineTime, parameters.declinePressure);
+}
+
+void PressureProfile::addPoint(float time, float pressure)
+{
+	if (m_count == kMaxPoints)
+		return;
+
+	m_points[m_count++] = { time, pressure };
+}
+
+float PressureProfile::setpointAt(float t) const
+{
+	if (m_count == 0)
+		return 0.0f;
+
+	if (t <= m_points[0].time)
+		return m_points[0].pressure;
+
+	for (size_t i = 1; i < m_count; ++i)
+	{
+		auto& a = m_points[i - 1];
+		auto& b = m_points[i];
+
+		if (t > b.time)
+			continue;
+
+		if (b.time <= a.time)
+			return b.pressure;
+
+		return a.pressure + (b.pressure - a.pressure) * (t - a.time) / (b.time - a.time);
+	}
+
+	return m_points[m_count - 1].pressure;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Brew pressure against shot time as a piecewise linear curve:
+ * pre-infusion hold, ramp to peak, peak hold, then a linear decline.
+ */
+class PressureProfile
+{
+public:
+	struct Point
+	{
+		float	time;		// seconds since the start of the shot
+		float	pressure;	// bar
+	};
+
+	struct Parameters
+	{
+		float	preinfusionPressure	= 3.0f;
+		float	preinfusionTime		= 8.0f;
+		float	rampTime			= 4.0f;
+		float	peakPressure		= 9.0f;
+		float	peakTime			= 10.0f;
+		float	declinePressure		= 6.0f;
+		float	declineTime			= 15.0f;
+	};
+
+	PressureProfile() = default;
+	explicit PressureProfile(const Parameters& parameters);
+
+	void addPoint(float time, float pressure);
+
+	// Pressure at t seconds, held at the last point afterwards
+	float setpointAt(float t) const;
+
+	float duration() const	{ return m_count ? m_points[m_count - 1].time : 0.0f; }
+
+private:
+	static constexpr size_t kMaxPoints = 16;
+
+	std::array<Point, kMaxPoints>	m_points;
+	size_t							m_count = 0;
+};
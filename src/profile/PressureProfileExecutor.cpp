@@ -0,0 +1,177 @@
+#include "PressureProfileExecutor.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+	constexpr auto kSetpointPeriod = std::chrono::milliseconds(100);
+	constexpr auto kLateThreshold = std::chrono::milliseconds(20);
+
+	// A stalled post costs a few deadlines rather than the rest of the shot
+	constexpr time_t kConnectTimeoutSec = 1;
+	constexpr time_t kReadTimeoutSec = 2;
+
+	const std::unordered_map<std::string, float PressureProfile::Parameters::*> kParameterSettings = {
+		{ "ProfilePreinfusionPressure",	&PressureProfile::Parameters::preinfusionPressure },
+		{ "ProfilePreinfusionTime",		&PressureProfile::Parameters::preinfusionTime },
+		{ "ProfileRampTime",			&PressureProfile::Parameters::rampTime },
+		{ "ProfilePeakPressure",		&PressureProfile::Parameters::peakPressure },
+		{ "ProfilePeakTime",			&PressureProfile::Parameters::peakTime },
+		{ "ProfileDeclinePressure",		&PressureProfile::Parameters::declinePressure },
+		{ "ProfileDeclineTime",			&PressureProfile::Parameters::declineTime },
+	};
+
+	void addTiming(std::chrono::nanoseconds& mean, std::chrono::nanoseconds& max, std::chrono::nanoseconds value, uint32_t count)
+	{
+		mean += (value - mean) / count;
+		max = std::max(max, value);
+	}
+}
+
+PressureProfileExecutor::PressureProfileExecutor(BoilerController& boiler, const std::string& url)
+	: m_boiler(boiler)
+	, m_httpClient(url)
+{
+	m_httpClient.set_keep_alive(true);
+	m_httpClient.set_connection_timeout(kConnectTimeoutSec, 0);
+	m_httpClient.set_read_timeout(kReadTimeoutSec, 0);
+
+	auto& settings = SettingsManager::get();
+
+	m_enabled = settings["PressureProfileEnabled"].getAs<bool>();
+	settings["PressureProfileEnabled"].registerDelegate(this);
+
+	for (auto& [key, member] : kParameterSettings)
+	{
+		m_parameters.*member = settings[key].getAs<float>();
+		settings[key].registerDelegate(this);
+	}
+
+	m_boiler.registerBoilerSampleDelegate(this);
+
+	m_thread = std::thread(&PressureProfileExecutor::run, this);
+}
+
+PressureProfileExecutor::~PressureProfileExecutor()
+{
+	m_boiler.deregisterBoilerSampleDelegate(this);
+
+	{
+		std::lock_guard lock(m_mutex);
+		m_quit = true;
+	}
+
+	m_cv.notify_all();
+	m_thread.join();
+
+	m_boiler.setPressureProfileActive(false);
+}
+
+PressureProfileExecutor::Stats PressureProfileExecutor::getStats() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_stats;
+}
+
+void PressureProfileExecutor::onChanged(const std::string& key, float val)
+{
+	if (auto it = kParameterSettings.find(key); it != kParameterSettings.end())
+		m_parameters.*(it->second) = val;
+}
+
+void PressureProfileExecutor::onChanged(const std::string& key, bool val)
+{
+	if (key == "PressureProfileEnabled")
+		m_enabled = val;
+}
+
+void PressureProfileExecutor::onBoilerSample(const BoilerSample& sample)
+{
+	auto brewing = sample.state == BoilerState::Brewing;
+
+	if (brewing == m_brewing)
+		return;
+
+	m_brewing = brewing;
+
+	{
+		std::lock_guard lock(m_mutex);
+
+		if (brewing && m_enabled)
+		{
+			// Samples reach delegates only after the whole poll, so the sample's own
+			// timestamp would already put step 0 in the past; start from now instead
+			m_profile = PressureProfile(m_parameters);
+			m_shotStart = std::chrono::steady_clock::now();
+			m_running = true;
+			m_stats.shots++;
+		}
+		else
+		{
+			m_running = false;
+		}
+	}
+
+	m_boiler.setPressureProfileActive(brewing && m_enabled);
+	m_cv.notify_all();
+}
+
+void PressureProfileExecutor::run()
+{
+	std::unique_lock lock(m_mutex);
+
+	while (! m_quit)
+	{
+		m_cv.wait(lock, [this] { return m_quit || m_running; });
+
+		auto shotStart = m_shotStart;
+		uint64_t step = 0;
+
+		while (! m_quit && m_running && shotStart == m_shotStart)
+		{
+			auto deadline = shotStart + step * kSetpointPeriod;
+
+			if (m_cv.wait_until(lock, deadline, [&] { return m_quit || ! m_running || shotStart != m_shotStart; }))
+				break;
+
+			auto wake = std::chrono::steady_clock::now();
+			auto setpoint = m_profile.setpointAt(std::chrono::duration<float>(deadline - shotStart).count());
+
+			lock.unlock();
+			auto ok = postSetpoint(setpoint);
+			auto posted = std::chrono::steady_clock::now();
+			lock.lock();
+
+			auto jitter = wake - deadline;
+
+			m_stats.setpoints++;
+			addTiming(m_stats.jitterMean, m_stats.jitterMax, jitter, m_stats.setpoints);
+			addTiming(m_stats.postMean, m_stats.postMax, posted - wake, m_stats.setpoints);
+
+			if (jitter > kLateThreshold)
+				m_stats.late++;
+
+			if (! ok)
+				m_stats.failed++;
+
+			// Resume on the next deadline still ahead, counting the ones missed
+			auto next = static_cast<uint64_t>((posted - shotStart) / kSetpointPeriod) + 1;
+			if (next > step + 1)
+				m_stats.skipped += static_cast<uint32_t>(next - step - 1);
+
+			step = next;
+		}
+	}
+}
+
+bool PressureProfileExecutor::postSetpoint(float pressure)
+{
+	nlohmann::json pressureJSON;
+	pressureJSON["brewTarget"] = pressure;
+
+	auto res = m_httpClient.Post("/api/v1/pressure/raw", pressureJSON.dump(), "application/json");
+	return res && res->status == 200;
+}
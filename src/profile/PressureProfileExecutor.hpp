@@ -0,0 +1,76 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "PressureProfile.hpp"
+#include "SettingsManager.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * Streams pressure profile setpoints to the controller while brewing.
+ *
+ * A dedicated thread wakes on a fixed deadline grid from the start of the
+ * shot and posts the interpolated setpoint over its own connection. Wake-up
+ * jitter and setpoints that went out late, had to be skipped or failed are counted,
+ * so it is visible when the transport cannot keep up with the profile.
+ */
+class PressureProfileExecutor
+	: public BoilerSampleDelegate
+	, public SettingDelegate
+{
+public:
+	struct Stats
+	{
+		uint32_t					shots		= 0;
+		uint32_t					setpoints	= 0;
+
+		// Sent later than kLateThreshold after their deadline
+		uint32_t					late		= 0;
+
+		// Deadlines dropped because the previous post overran them
+		uint32_t					skipped		= 0;
+
+		// Posts that timed out or were not accepted by the controller
+		uint32_t					failed		= 0;
+
+		std::chrono::nanoseconds	jitterMean	= {};
+		std::chrono::nanoseconds	jitterMax	= {};
+		std::chrono::nanoseconds	postMean	= {};
+		std::chrono::nanoseconds	postMax		= {};
+	};
+
+	PressureProfileExecutor(BoilerController& boiler, const std::string& url);
+	~PressureProfileExecutor();
+
+	Stats getStats() const;
+
+	// BoilerSampleDelegate i/f
+	void onBoilerSample(const BoilerSample& sample) override;
+
+	// SettingDelegate i/f
+	void onChanged(const std::string& key, float val) override;
+	void onChanged(const std::string& key, bool val) override;
+
+private:
+	void run();
+	bool postSetpoint(float pressure);
+
+	BoilerController&		m_boiler;
+	httplib::Client			m_httpClient;
+
+	bool					m_enabled	= false;
+	bool					m_brewing	= false;
+	PressureProfile::Parameters	m_parameters;
+
+	std::thread				m_thread;
+	mutable std::mutex		m_mutex;
+	std::condition_variable	m_cv;
+	bool					m_quit		= false;
+	bool					m_running	= false;
+	PressureProfile			m_profile;
+	std::chrono::steady_clock::time_point	m_shotStart;
+
+	Stats					m_stats;
+};
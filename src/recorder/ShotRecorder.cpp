@@ -0,0 +1,305 @@
+#include "ShotRecorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+	constexpr char kMagic[8] = { 'E', 'S', 'P', 'S', 'H', 'O', 'T', '1' };
+	constexpr uint32_t kVersion = 2;
+
+	constexpr size_t kHeaderSize = 4096;
+	// Bounds what a power loss can take; a crash of the client loses nothing
+	constexpr auto kSyncInterval = std::chrono::milliseconds(100);
+
+	size_t columnBytes(uint32_t capacity, size_t elementSize)
+	{
+		// Keep every column cache line aligned
+		return (capacity * elementSize + 63) & ~size_t(63);
+	}
+}
+
+ShotRecorder::ShotRecorder(const std::string& path, uint32_t capacity)
+	: m_capacity(capacity)
+	, m_mappingSize(mappingSize(capacity))
+{
+	m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (m_fd < 0)
+	{
+		printf("ShotRecorder -- unable to open %s\n", path.c_str());
+		return;
+	}
+
+	if (ftruncate(m_fd, m_mappingSize) != 0)
+	{
+		printf("ShotRecorder -- unable to size %s\n", path.c_str());
+		return;
+	}
+
+	m_mapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, 0);
+	if (m_mapping == MAP_FAILED)
+	{
+		printf("ShotRecorder -- unable to map %s\n", path.c_str());
+		m_mapping = nullptr;
+		return;
+	}
+
+	mapColumns();
+
+	m_header = reinterpret_cast<FileHeader*>(m_mapping);
+
+	// Continue an existing ring of the same layout, otherwise start afresh
+	if (memcmp(m_header->magic, kMagic, sizeof(kMagic)) != 0 || m_header->version != kVersion || m_header->capacity != capacity)
+	{
+		memset(m_mapping, 0, kHeaderSize);
+		memcpy(m_header->magic, kMagic, sizeof(kMagic));
+		m_header->version = kVersion;
+		m_header->capacity = capacity;
+		m_header->writeIndex.store(0, std::memory_order_release);
+	}
+
+	m_syncedIndex = m_header->writeIndex.load(std::memory_order_acquire);
+	m_syncThread = std::thread(&ShotRecorder::syncWorker, this);
+}
+
+ShotRecorder::ShotRecorder(const std::string& path)
+{
+	m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (m_fd < 0)
+		return;
+
+	FileHeader header;
+	if (pread(m_fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion)
+	{
+		printf("ShotRecorder -- %s is not a telemetry ring\n", path.c_str());
+		return;
+	}
+
+	m_capacity = header.capacity;
+	m_mappingSize = mappingSize(m_capacity);
+
+	struct stat fileStat;
+	if (fstat(m_fd, &fileStat) != 0 || size_t(fileStat.st_size) < m_mappingSize)
+	{
+		printf("ShotRecorder -- %s is truncated\n", path.c_str());
+		return;
+	}
+
+	m_mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (m_mapping == MAP_FAILED)
+	{
+		printf("ShotRecorder -- unable to map %s\n", path.c_str());
+		m_mapping = nullptr;
+		return;
+	}
+
+	mapColumns();
+
+	m_header = reinterpret_cast<FileHeader*>(m_mapping);
+	m_readOnly = true;
+}
+
+size_t ShotRecorder::mappingSize(uint32_t capacity)
+{
+	return kHeaderSize
+		+ columnBytes(capacity, sizeof(int64_t))
+		+ columnBytes(capacity, sizeof(int32_t))
+		+ columnBytes(capacity, sizeof(float)) * 5
+		+ columnBytes(capacity, sizeof(int32_t));
+}
+
+void ShotRecorder::mapColumns()
+{
+	auto base = static_cast<uint8_t*>(m_mapping);
+	auto offset = kHeaderSize;
+
+	m_timestamps = reinterpret_cast<int64_t*>(base + offset);	offset += columnBytes(m_capacity, sizeof(int64_t));
+	m_sources = reinterpret_cast<int32_t*>(base + offset);		offset += columnBytes(m_capacity, sizeof(int32_t));
+	m_temps = reinterpret_cast<float*>(base + offset);			offset += columnBytes(m_capacity, sizeof(float));
+	m_targetTemps = reinterpret_cast<float*>(base + offset);	offset += columnBytes(m_capacity, sizeof(float));
+	m_pressures = reinterpret_cast<float*>(base + offset);		offset += columnBytes(m_capacity, sizeof(float));
+	m_pumpDuties = reinterpret_cast<float*>(base + offset);		offset += columnBytes(m_capacity, sizeof(float));
+	m_weights = reinterpret_cast<float*>(base + offset);		offset += columnBytes(m_capacity, sizeof(float));
+	m_states = reinterpret_cast<int32_t*>(base + offset);
+}
+
+ShotRecorder::~ShotRecorder()
+{
+	if (m_syncThread.joinable())
+	{
+		{
+			std::lock_guard lock(m_syncMutex);
+			m_stopping = true;
+		}
+
+		m_syncCv.notify_all();
+		m_syncThread.join();
+	}
+
+	if (m_mapping)
+	{
+		if (! m_readOnly)
+			syncDirty(MS_SYNC);
+
+		munmap(m_mapping, m_mappingSize);
+	}
+
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+uint64_t ShotRecorder::size() const
+{
+	if (! m_header)
+		return 0;
+
+	return std::min<uint64_t>(m_header->writeIndex.load(std::memory_order_acquire), m_capacity);
+}
+
+ShotRecorder::Row ShotRecorder::row(uint64_t index) const
+{
+	if (! m_header)
+		return {};
+
+	auto writeIndex = m_header->writeIndex.load(std::memory_order_acquire);
+	auto slot = (writeIndex - size() + index) % m_capacity;
+
+	return {
+		m_timestamps[slot],
+		static_cast<Source>(m_sources[slot]),
+		m_temps[slot],
+		m_targetTemps[slot],
+		m_pressures[slot],
+		m_pumpDuties[slot],
+		m_weights[slot],
+		m_states[slot],
+	};
+}
+
+std::vector<ShotRecorder::Row> ShotRecorder::load(const std::string& path)
+{
+	ShotRecorder recorder(path);
+
+	std::vector<Row> rows;
+	rows.reserve(recorder.size());
+
+	for (uint64_t i = 0; i < recorder.size(); ++i)
+		rows.push_back(recorder.row(i));
+
+	return rows;
+}
+
+void ShotRecorder::onBoilerSample(const BoilerSample& sample)
+{
+	m_latest.currentTemp = sample.currentTemp;
+	m_latest.targetTemp = sample.targetTemp;
+	m_latest.currentPressure = sample.currentPressure;
+	m_latest.pumpDuty = sample.pumpDuty;
+	m_latest.state = static_cast<int32_t>(sample.state);
+
+	append(sample.timestamp, Source::Boiler);
+}
+
+void ShotRecorder::onScalesSample(const ScalesSample& sample)
+{
+	m_latest.weight = sample.weight;
+
+	append(sample.timestamp, Source::Scales);
+}
+
+void ShotRecorder::append(std::chrono::steady_clock::time_point timestamp, Source source)
+{
+	if (! m_header || m_readOnly)
+		return;
+
+	auto writeIndex = m_header->writeIndex.load(std::memory_order_relaxed);
+	auto slot = writeIndex % m_capacity;
+
+	m_timestamps[slot] = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+	m_sources[slot] = static_cast<int32_t>(source);
+	m_temps[slot] = m_latest.currentTemp;
+	m_targetTemps[slot] = m_latest.targetTemp;
+	m_pressures[slot] = m_latest.currentPressure;
+	m_pumpDuties[slot] = m_latest.pumpDuty;
+	m_weights[slot] = m_latest.weight;
+	m_states[slot] = m_latest.state;
+
+	m_header->writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void ShotRecorder::syncWorker()
+{
+	std::unique_lock lock(m_syncMutex);
+
+	while (! m_syncCv.wait_for(lock, kSyncInterval, [this] { return m_stopping; }))
+	{
+		lock.unlock();
+
+		// Waits for the new rows to reach storage; MS_ASYNC is a no-op on Linux
+		syncDirty(MS_SYNC);
+
+		lock.lock();
+	}
+}
+
+void ShotRecorder::syncDirty(int flags)
+{
+	auto writeIndex = m_header->writeIndex.load(std::memory_order_acquire);
+	if (writeIndex == m_syncedIndex)
+		return;
+
+	// Slots written since the last pass; a full lap means every slot
+	auto from = writeIndex - m_syncedIndex >= m_capacity ? 0 : m_syncedIndex % m_capacity;
+	auto to = writeIndex - m_syncedIndex >= m_capacity ? m_capacity : writeIndex % m_capacity;
+
+	auto syncColumn = [&](const void* column, size_t elementSize)
+	{
+		auto base = static_cast<const uint8_t*>(column);
+
+		if (from < to)
+		{
+			syncRange(base + from * elementSize, (to - from) * elementSize, flags);
+		}
+		else
+		{
+			syncRange(base + from * elementSize, (m_capacity - from) * elementSize, flags);
+			syncRange(base, to * elementSize, flags);
+		}
+	};
+
+	syncColumn(m_timestamps, sizeof(int64_t));
+	syncColumn(m_sources, sizeof(int32_t));
+	syncColumn(m_temps, sizeof(float));
+	syncColumn(m_targetTemps, sizeof(float));
+	syncColumn(m_pressures, sizeof(float));
+	syncColumn(m_pumpDuties, sizeof(float));
+	syncColumn(m_weights, sizeof(float));
+	syncColumn(m_states, sizeof(int32_t));
+
+	// The index only after its rows are on storage, so this pass never publishes
+	// an index ahead of them. Kernel writeback may still flush the header page
+	// early on its own, so after a power loss the newest rows may be stale.
+	syncRange(m_header, sizeof(FileHeader), flags);
+
+	m_syncedIndex = writeIndex;
+}
+
+void ShotRecorder::syncRange(const void* start, size_t length, int flags)
+{
+	if (length == 0)
+		return;
+
+	// msync wants a page aligned address
+	static const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+
+	auto address = reinterpret_cast<uintptr_t>(start);
+	auto aligned = address & ~(pageSize - 1);
+
+	msync(reinterpret_cast<void*>(aligned), length + (address - aligned), flags);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "ScalesController.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Records boiler and scales telemetry into a preallocated, memory-mapped
+ * ring file laid out column by column.
+ *
+ * Every sample writes one row holding the latest known value of every field.
+ * Rows are written straight into the shared mapping, so a crash of the client
+ * loses nothing that has been recorded; the write index is only advanced
+ * after a row is complete. A writeback thread synchronously flushes the
+ * rows appended since its last pass, then the header, every kSyncInterval,
+ * so a power loss loses at most that much and the telemetry path never
+ * touches msync.
+ */
+class ShotRecorder
+	: public BoilerSampleDelegate
+	, public ScalesSampleDelegate
+{
+public:
+	enum class Source : int32_t
+	{
+		Boiler,
+		Scales,
+	};
+
+	struct Row
+	{
+		int64_t	timestampNs;
+		Source	source;
+		float	currentTemp;
+		float	targetTemp;
+		float	currentPressure;
+		float	pumpDuty;
+		float	weight;
+		int32_t	state;
+	};
+
+	ShotRecorder(const std::string& path, uint32_t capacity);
+	~ShotRecorder();
+
+	ShotRecorder(const ShotRecorder&) = delete;
+	ShotRecorder& operator=(const ShotRecorder&) = delete;
+
+	bool isOpen() const			{ return m_header != nullptr; }
+
+	uint32_t capacity() const	{ return m_capacity; }
+	uint64_t size() const;
+
+	// Index is relative to the oldest row still held in the ring
+	Row row(uint64_t index) const;
+
+	// Reads a ring file back, oldest row first, without modifying it
+	static std::vector<Row> load(const std::string& path);
+
+	// BoilerSampleDelegate i/f
+	void onBoilerSample(const BoilerSample& sample) override;
+
+	// ScalesSampleDelegate i/f
+	void onScalesSample(const ScalesSample& sample) override;
+
+private:
+	struct FileHeader
+	{
+		char					magic[8];
+		uint32_t				version;
+		uint32_t				capacity;
+		std::atomic<uint64_t>	writeIndex;
+	};
+
+	explicit ShotRecorder(const std::string& path);
+
+	static size_t mappingSize(uint32_t capacity);
+	void mapColumns();
+
+	void append(std::chrono::steady_clock::time_point timestamp, Source source);
+
+	void syncWorker();
+	void syncDirty(int flags);
+	void syncRange(const void* start, size_t length, int flags);
+
+	uint32_t	m_capacity		= 0;
+	size_t		m_mappingSize	= 0;
+	int			m_fd			= -1;
+	void*		m_mapping		= nullptr;
+	bool		m_readOnly		= false;
+
+	FileHeader*	m_header		= nullptr;
+	int64_t*	m_timestamps	= nullptr;
+	int32_t*	m_sources		= nullptr;
+	float*		m_temps			= nullptr;
+	float*		m_targetTemps	= nullptr;
+	float*		m_pressures		= nullptr;
+	float*		m_pumpDuties	= nullptr;
+	float*		m_weights		= nullptr;
+	int32_t*	m_states		= nullptr;
+
+	Row			m_latest		= {};
+
+	// Sync thread only, until it is joined
+	uint64_t	m_syncedIndex	= 0;
+
+	std::thread				m_syncThread;
+	std::mutex				m_syncMutex;
+	std::condition_variable	m_syncCv;
+	bool					m_stopping	= false;
+};
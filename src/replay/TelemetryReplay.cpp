@@ -0,0 +1,128 @@
+#include "TelemetryReplay.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+TelemetryReplay::TelemetryReplay(std::vector<ShotRecorder::Row> rows, BoilerController& boiler, ScalesController& scales)
+	: m_rows(std::move(rows))
+	, m_boiler(boiler)
+	, m_scales(scales)
+{
+	if (! m_rows.empty())
+		m_virtualStart = TelemetryClock::time_point(std::chrono::nanoseconds(m_rows.front().timestampNs));
+
+	m_clock.set(m_virtualStart);
+
+	m_boiler.setClock(&m_clock);
+	m_scales.setClock(&m_clock);
+}
+
+TelemetryReplay::~TelemetryReplay()
+{
+	m_boiler.setClock(nullptr);
+	m_scales.setClock(nullptr);
+}
+
+void TelemetryReplay::tick()
+{
+	auto wallNow = std::chrono::steady_clock::now();
+
+	if (! m_started)
+	{
+		m_started = true;
+		m_wallStart = wallNow;
+	}
+
+	auto elapsed = std::chrono::duration<double, std::nano>(wallNow - m_wallStart) * m_speed;
+
+	advanceTo(m_virtualStart + std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+}
+
+void TelemetryReplay::step(std::chrono::nanoseconds delta)
+{
+	advanceTo(m_clock.now() + delta);
+}
+
+void TelemetryReplay::advanceTo(TelemetryClock::time_point now)
+{
+	while (m_next < m_rows.size())
+	{
+		auto& row = m_rows[m_next];
+		auto timestamp = TelemetryClock::time_point(std::chrono::nanoseconds(row.timestampNs));
+
+		if (timestamp > now)
+			break;
+
+		m_clock.set(timestamp);
+		inject(row);
+
+		++m_next;
+	}
+
+	m_clock.set(now);
+}
+
+void TelemetryReplay::inject(const ShotRecorder::Row& row)
+{
+	auto timestamp = TelemetryClock::time_point(std::chrono::nanoseconds(row.timestampNs));
+
+	if (row.source == ShotRecorder::Source::Scales)
+	{
+		m_scales.injectSample({ timestamp, row.weight });
+		return;
+	}
+
+	auto state = static_cast<BoilerState>(row.state);
+
+	m_boiler.injectSample({
+		timestamp,
+		row.currentTemp,
+		row.targetTemp,
+		row.currentPressure,
+		row.pumpDuty,
+		state,
+	});
+
+	if (state == BoilerState::Brewing && ! m_inShot)
+	{
+		m_inShot = true;
+		m_shotStart = timestamp;
+		m_shots.emplace_back();
+	}
+	else if (state != BoilerState::Brewing && m_inShot)
+	{
+		m_inShot = false;
+		m_shots.back().duration = timestamp - m_shotStart;
+	}
+}
+
+void TelemetryReplay::recordFrame(std::chrono::nanoseconds renderTime)
+{
+	if (! m_inShot)
+		return;
+
+	auto& shot = m_shots.back();
+
+	shot.frames++;
+	shot.renderTotal += renderTime;
+	shot.renderMax = std::max(shot.renderMax, renderTime);
+}
+
+void TelemetryReplay::printSummary() const
+{
+	printf("Replay -- %zu samples, %zu shots\n", m_rows.size(), m_shots.size());
+
+	for (size_t i = 0; i < m_shots.size(); ++i)
+	{
+		auto& shot = m_shots[i];
+		auto toMs = [](std::chrono::nanoseconds ns) { return std::chrono::duration<double, std::milli>(ns).count(); };
+
+		printf("Shot %zu: %.1fs, %u frames, render %.1fms total, %.2fms mean, %.2fms max\n",
+			   i + 1,
+			   toMs(shot.duration) / 1000.0,
+			   shot.frames,
+			   toMs(shot.renderTotal),
+			   shot.frames ? toMs(shot.renderTotal) / shot.frames : 0.0,
+			   toMs(shot.renderMax));
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "ScalesController.hpp"
+#include "ShotRecorder.hpp"
+#include "TelemetryClock.hpp"
+
+#include <vector>
+
+/**
+ * Replays a recorded telemetry session into offline controllers under a
+ * virtual clock, bypassing HTTP entirely.
+ *
+ * Samples go through the same path as live polls (sample delegates, display
+ * extrapolation, quantization, delegate fan-out), so the UI sees exactly
+ * what it would have seen on the machine, at any speed.
+ */
+class TelemetryReplay
+{
+public:
+	struct ShotStats
+	{
+		std::chrono::nanoseconds	duration		= {};
+		uint32_t					frames			= 0;
+		std::chrono::nanoseconds	renderTotal		= {};
+		std::chrono::nanoseconds	renderMax		= {};
+	};
+
+	TelemetryReplay(std::vector<ShotRecorder::Row> rows, BoilerController& boiler, ScalesController& scales);
+	~TelemetryReplay();
+
+	void setSpeed(float speed)			{ m_speed = speed; }
+
+	// Paces the virtual clock against wall time scaled by the replay speed
+	void tick();
+
+	// Advances the virtual clock by a fixed step, for deterministic runs
+	void step(std::chrono::nanoseconds delta);
+
+	// Render time of one UI frame, attributed to the shot in progress if any
+	void recordFrame(std::chrono::nanoseconds renderTime);
+
+	bool finished() const							{ return m_next >= m_rows.size(); }
+	const std::vector<ShotStats>& shots() const		{ return m_shots; }
+
+	void printSummary() const;
+
+private:
+	void advanceTo(TelemetryClock::time_point now);
+	void inject(const ShotRecorder::Row& row);
+
+	std::vector<ShotRecorder::Row>	m_rows;
+	size_t							m_next = 0;
+
+	BoilerController&				m_boiler;
+	ScalesController&				m_scales;
+	VirtualClock					m_clock;
+
+	float							m_speed = 1.0f;
+	bool							m_started = false;
+	std::chrono::steady_clock::time_point	m_wallStart;
+	TelemetryClock::time_point		m_virtualStart;
+
+	bool							m_inShot = false;
+	TelemetryClock::time_point		m_shotStart;
+	std::vector<ShotStats>			m_shots;
+};
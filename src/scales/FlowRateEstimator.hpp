@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * Streaming flow rate (g/s) from timestamped weight samples.
+ *
+ * The rate is the slope of a least-squares line through the last window
+ * samples, i.e. a first order Savitzky-Golay derivative that also copes with
+ * uneven poll spacing. Running sums make each sample O(1) and the window is
+ * a fixed ring, so memory is bounded.
+ */
+class FlowRateEstimator
+{
+public:
+	static constexpr size_t kMaxWindow = 32;
+
+	// Shared by the on-screen flow rate and brew-by-weight so the stop prediction matches the display
+	static constexpr size_t kDefaultWindow = 6;
+
+	explicit FlowRateEstimator(size_t window = kDefaultWindow)
+		: m_window(window < 2 ? 2 : (window > kMaxWindow ? kMaxWindow : window))
+	{ }
+
+	void addSample(std::chrono::steady_clock::time_point timestamp, float weight)
+	{
+		if (m_count == 0)
+			m_origin = timestamp;
+
+		auto t = std::chrono::duration<double>(timestamp - m_origin).count();
+
+		if (m_count == m_window)
+		{
+			auto& oldest = m_samples[m_head];
+			remove(oldest.t, oldest.w);
+		}
+		else
+		{
+			m_count++;
+		}
+
+		m_samples[m_head] = { t, weight };
+		m_head = (m_head + 1) % m_window;
+
+		add(t, weight);
+
+		// Keep times small so the sums stay precise over long sessions
+		if (t > kRebaseAfter)
+			rebase(t);
+	}
+
+	void reset()
+	{
+		m_count = 0;
+		m_head = 0;
+		m_sumT = m_sumW = m_sumTT = m_sumTW = 0.0;
+	}
+
+	size_t count() const	{ return m_count; }
+
+	float flowRate() const
+	{
+		if (m_count < 2)
+			return 0.0f;
+
+		auto n = static_cast<double>(m_count);
+		auto denominator = n * m_sumTT - m_sumT * m_sumT;
+
+		if (denominator <= 1e-12)
+			return 0.0f;
+
+		return static_cast<float>((n * m_sumTW - m_sumT * m_sumW) / denominator);
+	}
+
+private:
+	static constexpr double kRebaseAfter = 60.0;
+
+	struct Sample
+	{
+		double	t;
+		double	w;
+	};
+
+	void add(double t, double w)
+	{
+		m_sumT += t;
+		m_sumW += w;
+		m_sumTT += t * t;
+		m_sumTW += t * w;
+	}
+
+	void remove(double t, double w)
+	{
+		m_sumT -= t;
+		m_sumW -= w;
+		m_sumTT -= t * t;
+		m_sumTW -= t * w;
+	}
+
+	// Shifts the time origin forward by offset seconds
+	void rebase(double offset)
+	{
+		auto n = static_cast<double>(m_count);
+
+		m_sumTT += -2.0 * offset * m_sumT + n * offset * offset;
+		m_sumTW -= offset * m_sumW;
+		m_sumT -= n * offset;
+
+		for (size_t i = 0; i < m_count; ++i)
+			m_samples[i].t -= offset;
+
+		m_origin += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(offset));
+	}
+
+	const size_t					m_window;
+
+	std::array<Sample, kMaxWindow>	m_samples;
+	size_t							m_head	= 0;
+	size_t							m_count	= 0;
+
+	std::chrono::steady_clock::time_point	m_origin;
+
+	double	m_sumT	= 0.0;
+	double	m_sumW	= 0.0;
+	double	m_sumTT	= 0.0;
+	double	m_sumTW	= 0.0;
+};
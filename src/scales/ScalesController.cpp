@@ -3,12 +3,69 @@
 
 #include "nlohmann/json.hpp"
 
-ScalesController::ScalesController(const std::string& url)
-	: m_httpClient(url)
+#include <thread>
+
+namespace
+{
+	constexpr auto kWeightDisplayStep = 0.1f;
+	constexpr auto kWeightDisplayHysteresis = 0.02f;
+
+	constexpr auto kDisplayRefreshPeriod = std::chrono::milliseconds(16);
+	constexpr auto kMaxExtrapolation = std::chrono::milliseconds(250);
+
+	constexpr auto kInvalidWeight = -999.9f;
+
+	constexpr auto kFlowRateDisplayStep = 0.1f;
+	constexpr auto kFlowRateDisplayHysteresis = 0.02f;
+
+	// Poll cadence while no endpoint has a subscriber
+	constexpr auto kIdlePollDelay = std::chrono::milliseconds(100);
+
+	// Keeps scales that dropped off the network from holding a poll thread for long
+	constexpr time_t kConnectTimeoutSec = 1;
+	constexpr time_t kReadTimeoutSec = 2;
+
+	// Consecutive failed polls before the scales count as unreachable
+	constexpr uint32_t kMaxFailedPolls = 3;
+
+	// Device uptime in microseconds, reported by firmware that supports clock alignment
+	std::optional<int64_t> deviceTime(const nlohmann::json& json)
+	{
+		if (auto it = json.find("uptime_us"); it != json.end() && it->is_number_integer())
+			return it->get<int64_t>();
+
+		return std::nullopt;
+	}
+}
+
+ScalesController::ScalesController(const std::string& url, PollReactor* reactor)
+	: m_reactor(reactor)
+	, m_httpClient(url)
+	, m_url(url)
+	, m_currentWeightDisplay(kWeightDisplayStep, kWeightDisplayHysteresis)
+	, m_currentWeightModel(kMaxExtrapolation)
+	, m_flowRateDisplay(kFlowRateDisplayStep, kFlowRateDisplayHysteresis)
 {
 	m_httpClient.set_keep_alive(true);
+	m_httpClient.set_connection_timeout(kConnectTimeoutSec, 0);
+	m_httpClient.set_read_timeout(kReadTimeoutSec, 0);
 
-	m_pollFut = std::async(&ScalesController::pollRemoteServer, this);
+	schedulePoll();
+}
+
+ScalesController::~ScalesController()
+{
+	// Reactor futures do not block on destruction, so wait for an in-flight poll here
+	if (m_pollFut.valid())
+		m_pollFut.wait();
+}
+
+ScalesController::ScalesController()
+	: m_httpClient("")
+	, m_currentWeightDisplay(kWeightDisplayStep, kWeightDisplayHysteresis)
+	, m_currentWeightModel(kMaxExtrapolation)
+	, m_flowRateDisplay(kFlowRateDisplayStep, kFlowRateDisplayHysteresis)
+{
 }
 
 void ScalesController::registerWeightDelegate(ScalesWeightDelegate* delegate)
@@ -17,61 +74,255 @@ void ScalesController::registerWeightDelegate(ScalesWeightDelegate* delegate)
 		return;
 
 	m_delegates.emplace(delegate);
+	m_subscriptions.subscribe(EndpointWeight);
 
-	delegate->onScalesWeightChanged(m_currentWeight);
+	delegate->onScalesWeightChanged(m_currentWeightDisplay.valid() ? m_currentWeightDisplay.value() : m_currentWeight);
+	delegate->onScalesFlowRateChanged(m_flowRateDisplay.value());
 }
 
 void ScalesController::deregisterWeightDelegate(ScalesWeightDelegate* delegate)
 {
 	if (auto it = m_delegates.find(delegate); it != m_delegates.end())
+	{
 		m_delegates.erase(it);
+		m_subscriptions.unsubscribe(EndpointWeight);
+	}
 }
 
-void ScalesController::updateWeight(float weight)
+void ScalesController::registerSampleDelegate(ScalesSampleDelegate* delegate)
 {
-	if (m_currentWeight == weight)
-		return;
+	if (m_sampleDelegates.emplace(delegate).second)
+		m_subscriptions.subscribe(EndpointWeight);
+}
 
+void ScalesController::deregisterSampleDelegate(ScalesSampleDelegate* delegate)
+{
+	if (auto it = m_sampleDelegates.find(delegate); it != m_sampleDelegates.end())
+	{
+		m_sampleDelegates.erase(it);
+		m_subscriptions.unsubscribe(EndpointWeight);
+	}
+}
+
+void ScalesController::setRealtimeDelegate(ScalesRealtimeDelegate* delegate)
+{
+	// A poll in flight may already have loaded the previous delegate, so let it finish first
+	if (m_realtimeDelegate.load() && m_pollFut.valid())
+		m_pollFut.wait();
+
+	auto previous = m_realtimeDelegate.exchange(delegate);
+
+	if (delegate && ! previous)
+		m_subscriptions.subscribe(EndpointWeight);
+	else if (! delegate && previous)
+		m_subscriptions.unsubscribe(EndpointWeight);
+}
+
+void ScalesController::registerHealthDelegate(DeviceHealthSampleDelegate* delegate)
+{
+	if (m_healthDelegates.emplace(delegate).second)
+		m_subscriptions.subscribe(EndpointSysInfo);
+}
+
+void ScalesController::deregisterHealthDelegate(DeviceHealthSampleDelegate* delegate)
+{
+	if (auto it = m_healthDelegates.find(delegate); it != m_healthDelegates.end())
+	{
+		m_healthDelegates.erase(it);
+		m_subscriptions.unsubscribe(EndpointSysInfo);
+	}
+}
+
+void ScalesController::subscribe(uint32_t endpoints)
+{
+	m_subscriptions.subscribe(endpoints);
+}
+
+void ScalesController::unsubscribe(uint32_t endpoints)
+{
+	m_subscriptions.unsubscribe(endpoints);
+}
+
+void ScalesController::updateWeight(float weight)
+{
 	m_currentWeight = weight;
 
+	displayWeight(weight);
+}
+
+void ScalesController::displayWeight(float weight)
+{
+	if (! m_currentWeightDisplay.update(weight))
+		return;
+
 	for (auto delegate : m_delegates)
-		delegate->onScalesWeightChanged(weight);
+		delegate->onScalesWeightChanged(m_currentWeightDisplay.value());
 }
 
 void ScalesController::tick()
 {
-	if (m_pollFut.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
+	auto now = m_clock->now();
+
+	if (m_pollFut.valid() && m_pollFut.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
 	{
 		auto val = m_pollFut.get();
-		updateWeight(val.currentWeight);
 
-		m_pollFut = std::async(std::launch::async, &ScalesController::pollRemoteServer, this);
+		if (val.health)
+		{
+			for (auto delegate : m_healthDelegates)
+				delegate->onDeviceHealthSample(*val.health);
+		}
+
+		if (val.sampled)
+			processSample({ val.timestamp, val.currentWeight });
+
+		m_lastDisplayRefresh = now;
+
+		schedulePoll();
+	}
+	else if (now - m_lastDisplayRefresh >= kDisplayRefreshPeriod && m_currentWeightModel.valid())
+	{
+		m_lastDisplayRefresh = now;
+
+		displayWeight(m_currentWeightModel.valueAt(now));
 	}
 }
 
+void ScalesController::injectSample(const ScalesSample& sample)
+{
+	if (auto delegate = m_realtimeDelegate.load(); delegate && sample.weight != kInvalidWeight)
+		delegate->onScalesSampleRealtime(sample);
+
+	processSample(sample);
+
+	m_lastDisplayRefresh = m_clock->now();
+}
+
+void ScalesController::setClock(const TelemetryClock* clock)
+{
+	m_clock = clock ? clock : &TelemetryClock::steady();
+}
+
+void ScalesController::processSample(const ScalesSample& sample)
+{
+	if (sample.weight == kInvalidWeight)
+	{
+		m_currentWeightModel.reset();
+		m_flowRateEstimator.reset();
+	}
+	else
+	{
+		m_currentWeightModel.addSample(sample.timestamp, sample.weight);
+		m_flowRateEstimator.addSample(sample.timestamp, sample.weight);
+
+		for (auto delegate : m_sampleDelegates)
+			delegate->onScalesSample(sample);
+	}
+
+	updateWeight(sample.weight);
+	updateFlowRate(m_flowRateEstimator.flowRate());
+}
+
+void ScalesController::updateFlowRate(float flowRate)
+{
+	if (! m_flowRateDisplay.update(flowRate))
+		return;
+
+	for (auto delegate : m_delegates)
+		delegate->onScalesFlowRateChanged(m_flowRateDisplay.value());
+}
+
+void ScalesController::schedulePoll()
+{
+	auto idle = ! m_subscriptions.any();
+
+	// An idle back-off waits on the reactor's timer, not on a shared poll thread
+	if (m_reactor && idle)
+		m_pollFut = m_reactor->submitAfter(kIdlePollDelay, [this] { return pollRemoteServer(); });
+	else if (m_reactor)
+		m_pollFut = m_reactor->submit([this] { return pollRemoteServer(); });
+	else
+		m_pollFut = std::async(std::launch::async, [this, idle] {
+			if (idle)
+				std::this_thread::sleep_for(kIdlePollDelay);
+
+			return pollRemoteServer();
+		});
+}
+
 ScalesController::PollData ScalesController::pollRemoteServer()
 {
-	auto res = m_httpClient.Get("/api/v1/weight");
-	if (! res)
-		return { -999.9f };
+	PollData data = { kInvalidWeight, std::chrono::steady_clock::now(), false, std::nullopt };
+
+	if (! m_subscriptions.any())
+		return data;
+
+	if (m_subscriptions.active(EndpointWeight))
+	{
+		auto sent = std::chrono::steady_clock::now();
+		auto res = m_httpClient.Get("/api/v1/weight");
+		auto received = std::chrono::steady_clock::now();
+
+		data.timestamp = received;
+		data.sampled = true;
+
+		auto tempJSON = res && res->status == 200 ? nlohmann::json::parse(res->body, nullptr, false) : nlohmann::json();
+		if (! tempJSON.is_object() || ! tempJSON["weight"].is_number())
+		{
+			pollFailed();
+			return data;
+		}
 
-	auto tempJSON = nlohmann::json::parse(res->body);
-	auto currentWeight = tempJSON["weight"].get<float>();
+		data.currentWeight = tempJSON["weight"].get<float>();
 
-	res = m_httpClient.Get("/api/v1/sys/info");
-	if (! res)
-		return { -999.9f };
+		// Uptime going backwards means the scales restarted and the offset is stale
+		auto deviceTimeUs = deviceTime(tempJSON);
+		if (deviceTimeUs && m_lastDeviceTimeUs && *deviceTimeUs < *m_lastDeviceTimeUs)
+			m_clockSync.reset();
 
-	auto sysinfoJSON = nlohmann::json::parse(res->body);
-	auto freeHeap = sysinfoJSON["free_heap"].get<int>();
-	auto minFreeHeap = sysinfoJSON["min_free_heap"].get<int>();
+		m_lastDeviceTimeUs = deviceTimeUs;
 
-	static auto printTrigger = 20;
-	if (!--printTrigger)
+		data.timestamp = m_clockSync.place({ sent, received, deviceTimeUs });
+
+		if (auto delegate = m_realtimeDelegate.load())
+			delegate->onScalesSampleRealtime({ data.timestamp, data.currentWeight });
+	}
+
+	if (m_subscriptions.active(EndpointSysInfo))
 	{
-		printf("Scales -- Heap: %dKB (%dKB)\n", freeHeap/1024, minFreeHeap/1024);
-		printTrigger = 20;
+		auto res = m_httpClient.Get("/api/v1/sys/info");
+
+		auto sysinfoJSON = res && res->status == 200 ? nlohmann::json::parse(res->body, nullptr, false) : nlohmann::json();
+		if (! sysinfoJSON.is_object() || ! sysinfoJSON["free_heap"].is_number() || ! sysinfoJSON["min_free_heap"].is_number())
+		{
+			data.currentWeight = kInvalidWeight;
+			pollFailed();
+			return data;
+		}
+
+		data.health = DeviceHealthSample {
+			std::chrono::steady_clock::now(),
+			sysinfoJSON["free_heap"].get<int>(),
+			sysinfoJSON["min_free_heap"].get<int>(),
+		};
 	}
 
-	return { currentWeight };
+	m_failedPolls = 0;
+	m_reachable = true;
+
+	return data;
+}
+
+void ScalesController::pollFailed()
+{
+	if (++m_failedPolls != kMaxFailedPolls)
+		return;
+
+	printf("ScalesController: %s stopped answering\n", m_url.c_str());
+
+	m_reachable = false;
+	m_connectionLost = true;
+
+	// Round trips from before the outage say nothing about the path now
+	m_clockSync.reset();
 }
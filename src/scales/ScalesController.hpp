@@ -1,42 +1,154 @@
 #pragma once
 
 #include "SettingsManager.hpp"
+#include "PollReactor.hpp"
+#include "ClockSync.hpp"
+#include "DeviceHealth.hpp"
+#include "EndpointSubscriptions.hpp"
+#include "FlowRateEstimator.hpp"
+#include "QuantizedValue.hpp"
+#include "SampleExtrapolator.hpp"
+#include "TelemetryClock.hpp"
 
+#include <atomic>
 #include <set>
 #include <future>
+#include <optional>
 
 #include <httplib.h>
 
+struct ScalesSample
+{
+	std::chrono::steady_clock::time_point timestamp;
+
+	float	weight;
+};
+
 class ScalesWeightDelegate
 {
 public:
 	virtual void onScalesWeightChanged(float weight)		{ };
+	virtual void onScalesFlowRateChanged(float flowRate)	{ };
+};
+
+// Receives every valid, timestamped weight sample (before display quantization)
+class ScalesSampleDelegate
+{
+public:
+	virtual void onScalesSample(const ScalesSample& sample)	{ };
+};
+
+// Called on the poll thread as soon as a weight sample arrives; must not block
+class ScalesRealtimeDelegate
+{
+public:
+	virtual void onScalesSampleRealtime(const ScalesSample& sample)	{ };
 };
 
 class ScalesController
 {
 public:
-	ScalesController(const std::string& url);
+	// Remote endpoints, as subscription mask bits
+	enum Endpoint : uint32_t
+	{
+		EndpointWeight	= 1 << 0,
+		EndpointSysInfo	= 1 << 1,
+	};
+
+	// Polls run on the shared reactor when one is given, otherwise on their own thread
+	ScalesController(const std::string& url, PollReactor* reactor = nullptr);
+	~ScalesController();
+
+	// Offline controller with no remote, fed through injectSample() (e.g. replay)
+	ScalesController();
 
 	void registerWeightDelegate(ScalesWeightDelegate* delegate);
 	void deregisterWeightDelegate(ScalesWeightDelegate* delegate);
 
+	void registerSampleDelegate(ScalesSampleDelegate* delegate);
+	void deregisterSampleDelegate(ScalesSampleDelegate* delegate);
+
+	// Weight is only polled while a weight, sample or realtime delegate is registered.
+	// Main thread; waits out a poll in flight so the previous delegate is safe to destroy on return
+	void setRealtimeDelegate(ScalesRealtimeDelegate* delegate);
+
+	// Heap usage from sys/info, for HealthMonitor
+	void registerHealthDelegate(DeviceHealthSampleDelegate* delegate);
+	void deregisterHealthDelegate(DeviceHealthSampleDelegate* delegate);
+
+	// For consumers without a delegate
+	void subscribe(uint32_t endpoints);
+	void unsubscribe(uint32_t endpoints);
+
 	void tick();
 
+	void injectSample(const ScalesSample& sample);
+	void setClock(const TelemetryClock* clock);
+
+	UpdateCounters getWeightUpdateCounters() const	{ return m_currentWeightDisplay.counters(); }
+	UpdateCounters getFlowRateUpdateCounters() const	{ return m_flowRateDisplay.counters(); }
+
+	const ClockSync& getClockSync() const	{ return m_clockSync; }
+
+	const std::string& url() const			{ return m_url; }
+
+	// False once kMaxFailedPolls polls in a row have failed, until one succeeds
+	bool reachable() const					{ return m_reachable; }
+
+	// True once per loss of connection, e.g. to resolve the hostname again
+	bool takeConnectionLost()				{ return m_connectionLost.exchange(false); }
+
+	// True while a poll is in flight or waiting on the reactor; the destructor blocks on it
+	bool pollPending() const				{ return m_pollFut.valid() && m_pollFut.wait_for(std::chrono::seconds(0)) != std::future_status::ready; }
+
 private:
+	void processSample(const ScalesSample& sample);
+
 	void updateWeight(float weight);
+	void displayWeight(float weight);
+	void updateFlowRate(float flowRate);
 
 private:
 	struct PollData
 	{
 		float	currentWeight;
+
+		std::chrono::steady_clock::time_point timestamp;
+
+		// False when the weight endpoint was not fetched this cycle
+		bool	sampled;
+
+		std::optional<DeviceHealthSample> health;
 	};
 
 	PollData pollRemoteServer();
+	void schedulePoll();
+	void pollFailed();
 	std::future<PollData>				m_pollFut;
+	PollReactor*						m_reactor = nullptr;
 
 	std::set<ScalesWeightDelegate*>		m_delegates;
+	std::set<ScalesSampleDelegate*>		m_sampleDelegates;
+	std::atomic<ScalesRealtimeDelegate*>	m_realtimeDelegate = nullptr;
+	std::set<DeviceHealthSampleDelegate*>	m_healthDelegates;
+	EndpointSubscriptions<2>			m_subscriptions;
 	httplib::Client						m_httpClient;
+	ClockSync							m_clockSync;
+	const TelemetryClock*				m_clock = &TelemetryClock::steady();
+	const std::string					m_url;
+	std::atomic<bool>					m_reachable = true;
+	std::atomic<bool>					m_connectionLost = false;
+
+	// Poll thread only
+	uint32_t							m_failedPolls = 0;
+	std::optional<int64_t>				m_lastDeviceTimeUs;
 
 	float 								m_currentWeight = -999.9f;
+	QuantizedValue						m_currentWeightDisplay;
+
+	SampleExtrapolator					m_currentWeightModel;
+
+	FlowRateEstimator					m_flowRateEstimator;
+	QuantizedValue						m_flowRateDisplay;
+	TelemetryClock::time_point			m_lastDisplayRefresh;
 };
@@ -0,0 +1,468 @@
+#include "TelemetryServer.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <future>
+
+namespace
+{
+	constexpr auto kMainThreadTimeout = std::chrono::seconds(2);
+	constexpr size_t kMaxHistoryPoints = 100000;
+
+	// Setpoints outside these are rejected rather than clamped
+	constexpr float kMinBrewTemp = 20.0f;
+	constexpr float kMaxBrewTemp = 105.0f;
+	constexpr float kMinSteamTemp = 100.0f;
+	constexpr float kMaxSteamTemp = 160.0f;
+	constexpr float kMinBrewPressure = 0.0f;
+	constexpr float kMaxBrewPressure = 12.0f;
+
+	std::optional<int64_t> parseMs(const std::string& text)
+	{
+		int64_t value;
+		auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (ec != std::errc() || end != text.data() + text.size())
+			return std::nullopt;
+
+		return value;
+	}
+
+	// Absent is fine, present must be a number within range
+	bool validSetpoint(const nlohmann::json& bodyJSON, const char* field, float min, float max)
+	{
+		if (! bodyJSON.contains(field))
+			return true;
+
+		auto& valueJSON = bodyJSON[field];
+		if (! valueJSON.is_number())
+			return false;
+
+		auto value = valueJSON.get<double>();
+		return std::isfinite(value) && value >= min && value <= max;
+	}
+
+	bool isLoopback(const std::string& addr)
+	{
+		return addr == "127.0.0.1" || addr == "::1" || addr == "::ffff:127.0.0.1";
+	}
+
+	// Don't leak how much of the token matched through timing
+	bool tokenMatches(const std::string& given, const std::string& expected)
+	{
+		if (given.size() != expected.size())
+			return false;
+
+		unsigned char diff = 0;
+		for (size_t i = 0; i < given.size(); ++i)
+			diff |= given[i] ^ expected[i];
+
+		return diff == 0;
+	}
+
+	std::optional<TimeSeriesStore::Series> parseSeries(const std::string& name)
+	{
+		if (name == "temperature")
+			return TimeSeriesStore::Series::Temperature;
+		if (name == "pressure")
+			return TimeSeriesStore::Series::Pressure;
+
+		return std::nullopt;
+	}
+
+	std::optional<TimeSeriesStore::Resolution> parseResolution(const std::string& name)
+	{
+		if (name == "second")
+			return TimeSeriesStore::Resolution::Second;
+		if (name == "minute")
+			return TimeSeriesStore::Resolution::Minute;
+		if (name == "hour")
+			return TimeSeriesStore::Resolution::Hour;
+
+		return std::nullopt;
+	}
+
+	const char* alertName(HeapAlert alert)
+	{
+		switch (alert)
+		{
+			case HeapAlert::None:		return "none";
+			case HeapAlert::Leaking:	return "leaking";
+			case HeapAlert::Critical:	return "critical";
+		}
+
+		return "";
+	}
+
+	void setError(httplib::Response& res, int status, const char* message)
+	{
+		nlohmann::json errorJSON;
+		errorJSON["error"] = message;
+
+		res.status = status;
+		res.set_content(errorJSON.dump(), "application/json");
+	}
+}
+
+TelemetryServer::TelemetryServer(BoilerController& boiler, TimeSeriesStore& history)
+	: m_boiler(boiler)
+	, m_history(history)
+{
+	m_server.Get("/api/v1/snapshot", [this](const httplib::Request& req, httplib::Response& res) { handleSnapshot(req, res); });
+	m_server.Get("/api/v1/history", [this](const httplib::Request& req, httplib::Response& res) { handleHistory(req, res); });
+	m_server.Get("/api/v1/health", [this](const httplib::Request& req, httplib::Response& res) { handleHealth(req, res); });
+	m_server.Post("/api/v1/temp/raw", [this](const httplib::Request& req, httplib::Response& res) { handleTemp(req, res); });
+	m_server.Post("/api/v1/pressure/raw", [this](const httplib::Request& req, httplib::Response& res) { handlePressure(req, res); });
+	m_server.Post("/api/v1/pump/stop", [this](const httplib::Request& req, httplib::Response& res) { handlePumpStop(req, res); });
+}
+
+TelemetryServer::~TelemetryServer()
+{
+	stop();
+}
+
+void TelemetryServer::addHealthMonitor(const HealthMonitor& monitor)
+{
+	m_healthMonitors.push_back(&monitor);
+}
+
+void TelemetryServer::setApiToken(const std::string& token)
+{
+	m_apiToken = token;
+}
+
+bool TelemetryServer::start(const char* host, int port)
+{
+	if (! m_server.bind_to_port(host, port))
+	{
+		printf("TelemetryServer: Unable to listen on %s:%d\n", host, port);
+		return false;
+	}
+
+	m_thread = std::thread([this] { m_server.listen_after_bind(); });
+
+	printf("TelemetryServer: Listening on %s:%d%s\n", host, port, m_apiToken.empty() ? " (writes from localhost only)" : "");
+
+	return true;
+}
+
+void TelemetryServer::stop()
+{
+	if (! m_thread.joinable())
+		return;
+
+	m_server.stop();
+	m_thread.join();
+}
+
+void TelemetryServer::tick()
+{
+	std::deque<std::function<void()>> jobs;
+
+	{
+		std::lock_guard lock(m_jobMutex);
+		jobs.swap(m_jobs);
+	}
+
+	for (auto& job : jobs)
+		job();
+}
+
+void TelemetryServer::onBoilerSample(const BoilerSample& sample)
+{
+	std::lock_guard lock(m_snapshotMutex);
+
+	m_snapshot.boilerTimestampMs = TimeSeriesStore::wallClockMs(sample.timestamp);
+	m_snapshot.currentTemp = sample.currentTemp;
+	m_snapshot.targetTemp = sample.targetTemp;
+	m_snapshot.currentPressure = sample.currentPressure;
+	m_snapshot.pumpDuty = sample.pumpDuty;
+	m_snapshot.state = static_cast<int>(sample.state);
+	m_version++;
+}
+
+void TelemetryServer::onScalesSample(const ScalesSample& sample)
+{
+	std::lock_guard lock(m_snapshotMutex);
+
+	m_snapshot.scalesTimestampMs = TimeSeriesStore::wallClockMs(sample.timestamp);
+	m_snapshot.weight = sample.weight;
+	m_version++;
+}
+
+void TelemetryServer::handleSnapshot(const httplib::Request& req, httplib::Response& res)
+{
+	std::shared_ptr<const std::string> body;
+	uint64_t version;
+
+	{
+		std::lock_guard lock(m_snapshotMutex);
+
+		// Serialize once per new sample however many clients are polling
+		if (! m_cachedJSON || m_cachedVersion != m_version)
+		{
+			nlohmann::json snapshotJSON;
+			snapshotJSON["version"] = m_version;
+			snapshotJSON["boiler"]["timestamp"] = m_snapshot.boilerTimestampMs;
+			snapshotJSON["boiler"]["current"] = m_snapshot.currentTemp;
+			snapshotJSON["boiler"]["target"] = m_snapshot.targetTemp;
+			snapshotJSON["boiler"]["pressure"] = m_snapshot.currentPressure;
+			snapshotJSON["boiler"]["pump-duty"] = m_snapshot.pumpDuty;
+			snapshotJSON["boiler"]["state"] = m_snapshot.state;
+			snapshotJSON["scales"]["timestamp"] = m_snapshot.scalesTimestampMs;
+			snapshotJSON["scales"]["weight"] = m_snapshot.weight;
+
+			m_cachedJSON = std::make_shared<const std::string>(snapshotJSON.dump());
+			m_cachedVersion = m_version;
+		}
+
+		body = m_cachedJSON;
+		version = m_cachedVersion;
+	}
+
+	auto etag = "\"" + std::to_string(version) + "\"";
+	res.set_header("ETag", etag);
+	res.set_header("Cache-Control", "no-cache");
+
+	if (req.get_header_value("If-None-Match") == etag)
+	{
+		res.status = 304;
+		return;
+	}
+
+	res.set_content(*body, "application/json");
+}
+
+void TelemetryServer::handleHistory(const httplib::Request& req, httplib::Response& res)
+{
+	auto series = parseSeries(req.get_param_value("series"));
+	if (! series || ! req.has_param("from") || ! req.has_param("to"))
+	{
+		setError(res, 400, "series, from and to are required");
+		return;
+	}
+
+	auto from = parseMs(req.get_param_value("from"));
+	auto to = parseMs(req.get_param_value("to"));
+	if (! from || ! to)
+	{
+		setError(res, 400, "from and to must be integer milliseconds");
+		return;
+	}
+
+	auto fromMs = *from;
+	auto toMs = *to;
+
+	auto resolutionName = req.has_param("resolution") ? req.get_param_value("resolution") : "raw";
+	auto resolution = parseResolution(resolutionName);
+	if (! resolution && resolutionName != "raw")
+	{
+		setError(res, 400, "unknown resolution");
+		return;
+	}
+
+	// The store takes its own snapshot, so the query runs here rather than on the main thread
+	auto pointsJSON = nlohmann::json::array();
+
+	if (! resolution)
+	{
+		for (auto& point : m_history.range(*series, fromMs, toMs, kMaxHistoryPoints))
+			pointsJSON.push_back({ point.timestampMs, point.value });
+	}
+	else
+	{
+		for (auto& bucket : m_history.buckets(*series, *resolution, fromMs, toMs, kMaxHistoryPoints))
+			pointsJSON.push_back({ bucket.startMs, bucket.min, bucket.max, bucket.count ? bucket.sum / bucket.count : 0.0 });
+	}
+
+	res.set_content(pointsJSON.dump(), "application/json");
+}
+
+void TelemetryServer::handleHealth(const httplib::Request& req, httplib::Response& res)
+{
+	auto withSeries = req.get_param_value("series") == "1";
+
+	auto body = runOnMainThread([this, withSeries] {
+		auto devicesJSON = nlohmann::json::array();
+
+		for (auto monitor : m_healthMonitors)
+		{
+			auto& trend = monitor->trend();
+
+			nlohmann::json deviceJSON;
+			deviceJSON["device"] = monitor->device();
+			deviceJSON["free_heap"] = trend.freeHeap;
+			deviceJSON["min_free_heap"] = trend.minFreeHeap;
+			deviceJSON["heap_slope_per_hour"] = trend.slope;
+			deviceJSON["hours_to_exhaustion"] = trend.hoursToExhaustion;
+			deviceJSON["alert"] = alertName(trend.alert);
+
+			if (withSeries)
+			{
+				auto seriesJSON = nlohmann::json::array();
+
+				for (size_t i = 0; i < monitor->size(); ++i)
+				{
+					auto& point = monitor->point(i);
+					seriesJSON.push_back({ TimeSeriesStore::wallClockMs(point.timestamp), point.freeHeap, point.minFreeHeap });
+				}
+
+				deviceJSON["series"] = std::move(seriesJSON);
+			}
+
+			devicesJSON.push_back(std::move(deviceJSON));
+		}
+
+		return devicesJSON.dump();
+	});
+
+	if (! body)
+	{
+		setError(res, 503, "busy");
+		return;
+	}
+
+	res.set_content(*body, "application/json");
+}
+
+void TelemetryServer::handleTemp(const httplib::Request& req, httplib::Response& res)
+{
+	if (! authorizeWrite(req, res))
+		return;
+
+	auto tempJSON = nlohmann::json::parse(req.body, nullptr, false);
+	if (tempJSON.is_discarded() || ! tempJSON.is_object() || ! (tempJSON.contains("brewTarget") || tempJSON.contains("steamTarget")))
+	{
+		setError(res, 400, "brewTarget or steamTarget required");
+		return;
+	}
+
+	// Check every field before applying any, so a bad request changes nothing
+	if (! validSetpoint(tempJSON, "brewTarget", kMinBrewTemp, kMaxBrewTemp) ||
+		! validSetpoint(tempJSON, "steamTarget", kMinSteamTemp, kMaxSteamTemp))
+	{
+		setError(res, 400, "setpoint out of range");
+		return;
+	}
+
+	std::optional<float> brewTarget, steamTarget;
+	if (tempJSON.contains("brewTarget"))
+		brewTarget = tempJSON["brewTarget"].get<float>();
+	if (tempJSON.contains("steamTarget"))
+		steamTarget = tempJSON["steamTarget"].get<float>();
+
+	auto body = runOnMainThread([this, brewTarget, steamTarget] {
+		if (brewTarget)
+			m_boiler.setBoilerBrewTemp(*brewTarget);
+
+		if (steamTarget)
+			m_boiler.setBoilerSteamTemp(*steamTarget);
+
+		return std::string("{}");
+	});
+
+	if (! body)
+	{
+		setError(res, 503, "busy, not applied");
+		return;
+	}
+
+	res.set_content(*body, "application/json");
+}
+
+void TelemetryServer::handlePressure(const httplib::Request& req, httplib::Response& res)
+{
+	if (! authorizeWrite(req, res))
+		return;
+
+	auto pressureJSON = nlohmann::json::parse(req.body, nullptr, false);
+	if (pressureJSON.is_discarded() || ! pressureJSON.is_object() || ! pressureJSON.contains("brewTarget"))
+	{
+		setError(res, 400, "brewTarget required");
+		return;
+	}
+
+	if (! validSetpoint(pressureJSON, "brewTarget", kMinBrewPressure, kMaxBrewPressure))
+	{
+		setError(res, 400, "setpoint out of range");
+		return;
+	}
+
+	auto pressure = pressureJSON["brewTarget"].get<float>();
+
+	auto body = runOnMainThread([this, pressure] {
+		m_boiler.setBoilerBrewPressure(pressure);
+		return std::string("{}");
+	});
+
+	if (! body)
+	{
+		setError(res, 503, "busy, not applied");
+		return;
+	}
+
+	res.set_content(*body, "application/json");
+}
+
+void TelemetryServer::handlePumpStop(const httplib::Request& req, httplib::Response& res)
+{
+	if (! authorizeWrite(req, res))
+		return;
+
+	// stopPump() is safe from any thread and must not wait behind the main loop
+	m_boiler.stopPump();
+
+	res.set_content("{}", "application/json");
+}
+
+bool TelemetryServer::authorizeWrite(const httplib::Request& req, httplib::Response& res)
+{
+	if (m_apiToken.empty())
+	{
+		if (isLoopback(req.remote_addr))
+			return true;
+
+		setError(res, 403, "writes are only accepted from localhost");
+		return false;
+	}
+
+	if (! tokenMatches(req.get_header_value("Authorization"), "Bearer " + m_apiToken))
+	{
+		setError(res, 401, "missing or wrong API token");
+		return false;
+	}
+
+	return true;
+}
+
+std::optional<std::string> TelemetryServer::runOnMainThread(std::function<std::string()> job)
+{
+	enum { Pending, Started, Abandoned };
+
+	auto task = std::make_shared<std::packaged_task<std::string()>>(std::move(job));
+	auto state = std::make_shared<std::atomic<int>>(Pending);
+	auto fut = task->get_future();
+
+	{
+		std::lock_guard lock(m_jobMutex);
+		m_jobs.emplace_back([task, state] {
+			// The caller has already answered "not applied", so don't apply it
+			auto expected = int(Pending);
+			if (state->compare_exchange_strong(expected, Started))
+				(*task)();
+		});
+	}
+
+	if (fut.wait_for(kMainThreadTimeout) == std::future_status::ready)
+		return fut.get();
+
+	// Either tombstone the job before the main thread picks it up, or it has
+	// already started and the result is moments away
+	auto expected = int(Pending);
+	if (state->compare_exchange_strong(expected, Abandoned))
+		return std::nullopt;
+
+	return fut.get();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "HealthMonitor.hpp"
+#include "ScalesController.hpp"
+#include "TimeSeriesStore.hpp"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <httplib.h>
+
+/**
+ * Local read-through API so phones and other dashboards talk to the Pi
+ * rather than the ESP32.
+ *
+ * Reads are served from what the client already polls: the latest sample
+ * snapshot (serialized once per new sample, with an ETag so unchanged
+ * snapshots cost a 304) and the local history store. Writes are handed to
+ * the main thread and go out through the normal controller command path.
+ * Nothing here issues requests to the controller of its own.
+ *
+ * Writes are accepted from localhost only, or with
+ * "Authorization: Bearer <token>" once an API token is set. Setpoints are
+ * range checked and a request is applied whole or not at all.
+ *
+ *   GET  /api/v1/snapshot
+ *   GET  /api/v1/history?series=temperature|pressure&from=<ms>&to=<ms>[&resolution=raw|second|minute|hour]
+ *   GET  /api/v1/health[?series=1]
+ *   POST /api/v1/temp/raw        {"brewTarget": x} or {"steamTarget": x}
+ *   POST /api/v1/pressure/raw    {"brewTarget": x}
+ *   POST /api/v1/pump/stop
+ */
+class TelemetryServer : public BoilerSampleDelegate, public ScalesSampleDelegate
+{
+public:
+	TelemetryServer(BoilerController& boiler, TimeSeriesStore& history);
+	~TelemetryServer();
+
+	// Devices reported by /api/v1/health; call from the main thread
+	void addHealthMonitor(const HealthMonitor& monitor);
+
+	// Allow writes from other hosts that present this token; call before start()
+	void setApiToken(const std::string& token);
+
+	bool start(const char* host, int port);
+	void stop();
+
+	// Runs queued commands; call from the main loop
+	void tick();
+
+	// BoilerSampleDelegate i/f
+	void onBoilerSample(const BoilerSample& sample) override;
+
+	// ScalesSampleDelegate i/f
+	void onScalesSample(const ScalesSample& sample) override;
+
+private:
+	struct Snapshot
+	{
+		int64_t		boilerTimestampMs = 0;
+		float		currentTemp = 0.0f;
+		float		targetTemp = 0.0f;
+		float		currentPressure = 0.0f;
+		float		pumpDuty = 0.0f;
+		int			state = 0;
+
+		int64_t		scalesTimestampMs = 0;
+		float		weight = 0.0f;
+	};
+
+	void handleSnapshot(const httplib::Request& req, httplib::Response& res);
+	void handleHistory(const httplib::Request& req, httplib::Response& res);
+	void handleHealth(const httplib::Request& req, httplib::Response& res);
+	void handleTemp(const httplib::Request& req, httplib::Response& res);
+	void handlePressure(const httplib::Request& req, httplib::Response& res);
+	void handlePumpStop(const httplib::Request& req, httplib::Response& res);
+
+	// Sets an error response and returns false if the request may not write
+	bool authorizeWrite(const httplib::Request& req, httplib::Response& res);
+
+	// Blocks the server thread until the main thread has run the job; on
+	// timeout the job is dropped unrun and nullopt returned
+	std::optional<std::string> runOnMainThread(std::function<std::string()> job);
+
+	BoilerController&					m_boiler;
+	TimeSeriesStore&					m_history;
+	std::vector<const HealthMonitor*>	m_healthMonitors;
+
+	std::string							m_apiToken;
+	httplib::Server						m_server;
+	std::thread							m_thread;
+
+	std::mutex							m_snapshotMutex;
+	Snapshot							m_snapshot;
+	uint64_t							m_version = 0;
+	uint64_t							m_cachedVersion = 0;
+	std::shared_ptr<const std::string>	m_cachedJSON;
+
+	std::mutex							m_jobMutex;
+	std::deque<std::function<void()>>	m_jobs;
+};
@@ -0,0 +1,44 @@
+#include "ShotLog.hpp"
+
+#include <ctime>
+
+ShotLog::ShotLog(const char* path, const TemperatureStability& stability)
+	: m_stability(stability)
+{
+	m_file = fopen(path, "a");
+	if (! m_file)
+	{
+		printf("ShotLog: Unable to open %s\n", path);
+		return;
+	}
+
+	if (ftell(m_file) == 0)
+		fprintf(m_file, "start,duration,mean,stddev,slope,overshoot,stable\n");
+}
+
+ShotLog::~ShotLog()
+{
+	if (m_file)
+		fclose(m_file);
+}
+
+void ShotLog::onShotStarted()
+{
+	m_startTime = time(nullptr);
+	m_startStats = m_stability.stats();
+}
+
+void ShotLog::onShotStopped(float seconds)
+{
+	if (! m_file)
+		return;
+
+	char start[32];
+	strftime(start, sizeof(start), "%Y-%m-%dT%H:%M:%S", localtime(&m_startTime));
+
+	fprintf(m_file, "%s,%.1f,%.2f,%.3f,%.4f,%.2f,%d\n",
+			start, seconds,
+			m_startStats.mean, m_startStats.stddev, m_startStats.slope, m_startStats.overshoot,
+			m_startStats.stable);
+	fflush(m_file);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ShotSession.hpp"
+#include "TemperatureStability.hpp"
+
+#include <cstdio>
+
+/**
+ * Appends one CSV line per shot: wall-clock start, duration, and the
+ * temperature stability snapshot taken when the shot started.
+ */
+class ShotLog : public ShotTimerDelegate
+{
+public:
+	ShotLog(const char* path, const TemperatureStability& stability);
+	~ShotLog();
+
+	// ShotTimerDelegate i/f
+	void onShotStarted() override;
+	void onShotStopped(float seconds) override;
+
+private:
+	const TemperatureStability&	m_stability;
+
+	FILE*						m_file;
+	time_t						m_startTime = 0;
+	TemperatureStats			m_startStats;
+};
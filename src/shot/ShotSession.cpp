@@ -0,0 +1,129 @@
+#include "ShotSession.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr auto kStartPressure = 1.5f;
+	constexpr auto kStopPressure = 1.0f;
+}
+
+ShotSession::ShotSession(BoilerController& boiler)
+	: m_boiler(boiler)
+{
+	m_boiler.setRealtimeDelegate(this);
+}
+
+ShotSession::~ShotSession()
+{
+	m_boiler.setRealtimeDelegate(nullptr);
+}
+
+void ShotSession::registerShotTimerDelegate(ShotTimerDelegate* delegate)
+{
+	m_delegates.emplace(delegate);
+}
+
+void ShotSession::deregisterShotTimerDelegate(ShotTimerDelegate* delegate)
+{
+	if (auto it = m_delegates.find(delegate); it != m_delegates.end())
+		m_delegates.erase(it);
+}
+
+void ShotSession::setClock(const TelemetryClock* clock)
+{
+	m_clock = clock ? clock : &TelemetryClock::steady();
+}
+
+void ShotSession::onBoilerSampleRealtime(const BoilerSample& sample)
+{
+	auto brewing = sample.state == BoilerState::Brewing;
+
+	switch (m_state)
+	{
+	case State::Idle:
+		if (m_havePrevious && (brewing || sample.currentPressure >= kStartPressure))
+		{
+			m_state = State::Brewing;
+
+			std::lock_guard lock(m_mutex);
+			m_edges.generation++;
+			m_edges.running = true;
+			m_edges.start = estimateEdge(sample, kStartPressure);
+		}
+		break;
+
+	case State::Brewing:
+		if (! brewing && sample.currentPressure < kStopPressure)
+		{
+			m_state = State::Idle;
+
+			std::lock_guard lock(m_mutex);
+			m_edges.running = false;
+			m_edges.stop = std::max(m_edges.start, estimateEdge(sample, kStopPressure));
+		}
+		break;
+	}
+
+	m_previous = sample;
+	m_havePrevious = true;
+}
+
+TelemetryClock::time_point ShotSession::estimateEdge(const BoilerSample& sample, float threshold) const
+{
+	auto t0 = m_previous.timestamp;
+	auto t1 = sample.timestamp;
+	auto p0 = m_previous.currentPressure;
+	auto p1 = sample.currentPressure;
+
+	// Without a pressure crossing all we know is the edge lies between the samples
+	auto crossed = (p0 < threshold) != (p1 < threshold);
+	if (! crossed || p1 == p0 || t1 <= t0)
+		return t0 + (t1 - t0) / 2;
+
+	auto fraction = std::clamp((threshold - p0) / (p1 - p0), 0.0f, 1.0f);
+
+	return t0 + std::chrono::duration_cast<TelemetryClock::time_point::duration>((t1 - t0) * fraction);
+}
+
+void ShotSession::tick()
+{
+	Edges edges;
+	{
+		std::lock_guard lock(m_mutex);
+		edges = m_edges;
+	}
+
+	if (edges.generation != m_seenGeneration)
+	{
+		m_seenGeneration = edges.generation;
+		m_seenRunning = true;
+		m_lastTenths = -1;
+
+		for (auto delegate : m_delegates)
+			delegate->onShotStarted();
+	}
+
+	if (! m_seenRunning)
+		return;
+
+	auto end = edges.running ? m_clock->now() : edges.stop;
+	auto seconds = std::max(0.0f, std::chrono::duration<float>(end - edges.start).count());
+
+	// The readout shows tenths of a second, only fan out when they change
+	if (auto tenths = static_cast<int>(seconds * 10.0f); tenths != m_lastTenths)
+	{
+		m_lastTenths = tenths;
+
+		for (auto delegate : m_delegates)
+			delegate->onShotTimerChanged(seconds);
+	}
+
+	if (! edges.running)
+	{
+		m_seenRunning = false;
+
+		for (auto delegate : m_delegates)
+			delegate->onShotStopped(seconds);
+	}
+}
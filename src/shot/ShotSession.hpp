@@ -0,0 +1,77 @@
+#pragma once
+
+#include "BoilerController.hpp"
+#include "TelemetryClock.hpp"
+
+#include <mutex>
+#include <set>
+
+class ShotTimerDelegate
+{
+public:
+	virtual void onShotStarted()							{ };
+	virtual void onShotTimerChanged(float seconds)			{ };
+	virtual void onShotStopped(float seconds)				{ };
+};
+
+/**
+ * Detects shots from the boiler telemetry and times them.
+ *
+ * The state machine runs on the boiler poll thread. A shot starts when the
+ * controller reports Brewing or the pressure rises through kStartPressure,
+ * and stops on the reverse. Rather than using the time the edge was noticed,
+ * each edge is placed between the two samples that bracket it, using the
+ * pressure slope across them. The UI timer is then driven from the sample
+ * clock in tick().
+ */
+class ShotSession : public BoilerRealtimeDelegate
+{
+public:
+	explicit ShotSession(BoilerController& boiler);
+	~ShotSession();
+
+	void registerShotTimerDelegate(ShotTimerDelegate* delegate);
+	void deregisterShotTimerDelegate(ShotTimerDelegate* delegate);
+
+	void setClock(const TelemetryClock* clock);
+
+	// Fans the timer out to delegates, on the UI thread
+	void tick();
+
+	// BoilerRealtimeDelegate i/f
+	void onBoilerSampleRealtime(const BoilerSample& sample) override;
+
+private:
+	enum class State
+	{
+		Idle,
+		Brewing,
+	};
+
+	struct Edges
+	{
+		uint32_t					generation	= 0;
+		bool						running		= false;
+		TelemetryClock::time_point	start;
+		TelemetryClock::time_point	stop;
+	};
+
+	TelemetryClock::time_point estimateEdge(const BoilerSample& sample, float threshold) const;
+
+	BoilerController&				m_boiler;
+	const TelemetryClock*			m_clock = &TelemetryClock::steady();
+
+	// Poll thread only
+	State							m_state = State::Idle;
+	bool							m_havePrevious = false;
+	BoilerSample					m_previous;
+
+	mutable std::mutex				m_mutex;
+	Edges							m_edges;
+
+	// UI thread only
+	std::set<ShotTimerDelegate*>	m_delegates;
+	uint32_t						m_seenGeneration = 0;
+	bool							m_seenRunning = false;
+	int								m_lastTenths = -1;
+};
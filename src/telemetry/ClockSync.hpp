@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+/**
+ * NTP-style clock alignment for one remote device, built from the round
+ * trips of ordinary poll requests.
+ *
+ * Each exchange is bracketed by local send/receive times. A reading taken
+ * by the device lies somewhere inside that bracket, so without further
+ * information the midpoint is the best estimate (error at most RTT / 2).
+ * When the device also reports its own clock, the offset between the two
+ * clocks is estimated from the exchange with the smallest round trip in a
+ * short window (the NTP clock filter) and samples are placed at the
+ * device's timestamp mapped onto the local steady clock.
+ *
+ * Exchanges are added from the poll thread; offset() and roundTrip() may be
+ * read from any thread.
+ */
+class ClockSync
+{
+public:
+	using time_point = std::chrono::steady_clock::time_point;
+	using duration = std::chrono::steady_clock::duration;
+
+	static constexpr size_t kWindow = 8;
+
+	struct Exchange
+	{
+		time_point	sent;
+		time_point	received;
+
+		// Device clock reading in microseconds, if the response carries one
+		std::optional<int64_t>	deviceTimeUs;
+	};
+
+	// Records an exchange and returns where its reading belongs on the local timeline
+	time_point place(const Exchange& exchange)
+	{
+		auto roundTrip = exchange.received - exchange.sent;
+		auto midpoint = exchange.sent + roundTrip / 2;
+
+		m_roundTrip = std::chrono::duration_cast<std::chrono::microseconds>(roundTrip).count();
+
+		if (! exchange.deviceTimeUs)
+			return midpoint;
+
+		auto local = std::chrono::duration_cast<std::chrono::microseconds>(midpoint.time_since_epoch()).count();
+		m_filter[m_head] = { roundTrip, *exchange.deviceTimeUs - local };
+		m_head = (m_head + 1) % kWindow;
+		if (m_count < kWindow)
+			m_count++;
+
+		auto best = m_filter[0];
+		for (size_t i = 1; i < m_count; ++i)
+		{
+			if (m_filter[i].roundTrip < best.roundTrip)
+				best = m_filter[i];
+		}
+
+		m_offset = best.offsetUs;
+		m_synced = true;
+
+		auto placed = time_point(std::chrono::microseconds(*exchange.deviceTimeUs - best.offsetUs));
+
+		// The reading was taken while the request was in flight
+		if (placed < exchange.sent)
+			return exchange.sent;
+		if (placed > exchange.received)
+			return exchange.received;
+
+		return placed;
+	}
+
+	void reset()
+	{
+		m_head = 0;
+		m_count = 0;
+		m_synced = false;
+	}
+
+	// Device clock minus local clock; only meaningful once synced()
+	std::chrono::microseconds offset() const	{ return std::chrono::microseconds(m_offset.load()); }
+	std::chrono::microseconds roundTrip() const	{ return std::chrono::microseconds(m_roundTrip.load()); }
+	bool synced() const							{ return m_synced; }
+
+private:
+	struct Entry
+	{
+		duration	roundTrip;
+		int64_t		offsetUs;
+	};
+
+	std::array<Entry, kWindow>	m_filter;
+	size_t						m_head = 0;
+	size_t						m_count = 0;
+
+	std::atomic<int64_t>		m_offset = 0;
+	std::atomic<int64_t>		m_roundTrip = 0;
+	std::atomic<bool>			m_synced = false;
+};
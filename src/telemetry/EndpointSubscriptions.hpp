@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Reference counts for the remote endpoints a controller polls, one per bit
+ * of an endpoint mask. Delegate registration subscribes the endpoints that
+ * feed it and deregistration releases them, so an endpoint is fetched only
+ * while something is listening.
+ *
+ * Counts change on the main thread and are read by the poll thread.
+ */
+template<size_t Count>
+class EndpointSubscriptions
+{
+public:
+	void subscribe(uint32_t endpoints)
+	{
+		for (size_t i = 0; i < Count; ++i)
+		{
+			if (endpoints & (1u << i))
+				m_counts[i]++;
+		}
+	}
+
+	void unsubscribe(uint32_t endpoints)
+	{
+		for (size_t i = 0; i < Count; ++i)
+		{
+			if ((endpoints & (1u << i)) && m_counts[i] > 0)
+				m_counts[i]--;
+		}
+	}
+
+	bool active(uint32_t endpoint) const
+	{
+		for (size_t i = 0; i < Count; ++i)
+		{
+			if ((endpoint & (1u << i)) && m_counts[i] > 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	bool any() const
+	{
+		return active((1u << Count) - 1);
+	}
+
+private:
+	std::array<std::atomic<int>, Count>	m_counts = {};
+};
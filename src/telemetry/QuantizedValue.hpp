@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+struct UpdateCounters
+{
+	uint64_t forwarded	= 0;
+	uint64_t suppressed	= 0;
+};
+
+/**
+ * Display-side quantization of a noisy sensor value.
+ *
+ * The value is snapped to multiples of step, and a new raw value is only
+ * forwarded once it leaves the current step by more than the hysteresis
+ * band, so noise around a step boundary does not make the readout flicker.
+ */
+class QuantizedValue
+{
+public:
+	QuantizedValue(float step, float hysteresis)
+		: m_step(step)
+		, m_hysteresis(hysteresis)
+	{ }
+
+	// Returns true if the displayed value changed and should be forwarded
+	bool update(float raw)
+	{
+		if (m_valid && std::fabs(raw - m_value) < m_step * 0.5f + m_hysteresis)
+		{
+			m_suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		m_value = std::round(raw / m_step) * m_step;
+		m_valid = true;
+
+		m_forwarded.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	float value() const			{ return m_value; }
+	bool valid() const			{ return m_valid; }
+
+	UpdateCounters counters() const
+	{
+		return { m_forwarded.load(std::memory_order_relaxed), m_suppressed.load(std::memory_order_relaxed) };
+	}
+
+private:
+	const float				m_step;
+	const float				m_hysteresis;
+
+	float					m_value = 0.0f;
+	bool					m_valid = false;
+
+	std::atomic<uint64_t>	m_forwarded		= 0;
+	std::atomic<uint64_t>	m_suppressed	= 0;
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Mean, variance and least-squares slope of a value over a sliding time
+ * window, updated in O(1) per sample.
+ *
+ * Samples live in a ring preallocated at construction, so adding samples
+ * never allocates. Values and times are kept relative to a reference to
+ * avoid cancellation in the running sums, and the sums are rebuilt from the
+ * ring every capacity samples (amortized O(1)) so rounding cannot drift.
+ */
+class RollingStats
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	RollingStats(Clock::duration window, size_t capacity)
+		: m_window(std::chrono::duration<double>(window).count())
+		, m_samples(capacity)
+	{ }
+
+	void add(Clock::time_point timestamp, float value)
+	{
+		if (m_count == 0)
+		{
+			m_origin = timestamp;
+			m_reference = value;
+		}
+
+		auto t = std::chrono::duration<double>(timestamp - m_origin).count();
+		auto x = static_cast<double>(value) - m_reference;
+
+		if (m_count == m_samples.size())
+			evictOldest();
+
+		m_samples[(m_head + m_count) % m_samples.size()] = { t, x };
+		m_count++;
+		accumulate(t, x, 1.0);
+
+		while (m_count > 1 && t - oldest().t > m_window)
+			evictOldest();
+
+		if (++m_sinceRebuild >= m_samples.size())
+			rebuild();
+	}
+
+	void reset()
+	{
+		m_head = m_count = m_sinceRebuild = 0;
+		m_sumT = m_sumX = m_sumTT = m_sumTX = m_sumXX = 0.0;
+	}
+
+	size_t count() const	{ return m_count; }
+
+	// Seconds between the oldest and newest sample
+	double span() const		{ return m_count > 1 ? newest().t - oldest().t : 0.0; }
+
+	double mean() const
+	{
+		return m_count ? m_reference + m_sumX / m_count : 0.0;
+	}
+
+	double variance() const
+	{
+		if (m_count < 2)
+			return 0.0;
+
+		auto n = static_cast<double>(m_count);
+		auto v = (m_sumXX - m_sumX * m_sumX / n) / (n - 1.0);
+
+		return v > 0.0 ? v : 0.0;
+	}
+
+	// Units per second
+	double slope() const
+	{
+		if (m_count < 2)
+			return 0.0;
+
+		auto n = static_cast<double>(m_count);
+		auto denominator = n * m_sumTT - m_sumT * m_sumT;
+
+		return denominator > 1e-12 ? (n * m_sumTX - m_sumT * m_sumX) / denominator : 0.0;
+	}
+
+private:
+	struct Sample
+	{
+		double	t;
+		double	x;
+	};
+
+	const Sample& oldest() const	{ return m_samples[m_head]; }
+	const Sample& newest() const	{ return m_samples[(m_head + m_count - 1) % m_samples.size()]; }
+
+	void evictOldest()
+	{
+		auto& sample = oldest();
+		accumulate(sample.t, sample.x, -1.0);
+
+		m_head = (m_head + 1) % m_samples.size();
+		m_count--;
+	}
+
+	void accumulate(double t, double x, double sign)
+	{
+		m_sumT += sign * t;
+		m_sumX += sign * x;
+		m_sumTT += sign * t * t;
+		m_sumTX += sign * t * x;
+		m_sumXX += sign * x * x;
+	}
+
+	// Recomputes the sums, re-centring time on the oldest sample
+	void rebuild()
+	{
+		m_sinceRebuild = 0;
+		m_sumT = m_sumX = m_sumTT = m_sumTX = m_sumXX = 0.0;
+
+		auto shift = oldest().t;
+		m_origin += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(shift));
+
+		for (size_t i = 0; i < m_count; ++i)
+		{
+			auto& sample = m_samples[(m_head + i) % m_samples.size()];
+			sample.t -= shift;
+			accumulate(sample.t, sample.x, 1.0);
+		}
+	}
+
+	const double		m_window;
+
+	std::vector<Sample>	m_samples;
+	size_t				m_head			= 0;
+	size_t				m_count			= 0;
+	size_t				m_sinceRebuild	= 0;
+
+	Clock::time_point	m_origin;
+	double				m_reference		= 0.0;
+
+	double	m_sumT	= 0.0;
+	double	m_sumX	= 0.0;
+	double	m_sumTT	= 0.0;
+	double	m_sumTX	= 0.0;
+	double	m_sumXX	= 0.0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * Display-side model of a polled value.
+ *
+ * Between polls the value is extrapolated along the slope of the last two
+ * samples, for at most maxExtrapolation past the newest sample. A new sample
+ * always replaces the prediction, so the readout snaps back to the true value.
+ */
+class SampleExtrapolator
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit SampleExtrapolator(Clock::duration maxExtrapolation)
+		: m_maxExtrapolation(maxExtrapolation)
+	{ }
+
+	void addSample(Clock::time_point timestamp, float value)
+	{
+		m_slope = 0.0f;
+
+		if (m_valid && timestamp > m_timestamp)
+			m_slope = (value - m_value) / std::chrono::duration<float>(timestamp - m_timestamp).count();
+
+		m_timestamp = timestamp;
+		m_value = value;
+		m_valid = true;
+	}
+
+	void reset()
+	{
+		m_valid = false;
+		m_slope = 0.0f;
+	}
+
+	float valueAt(Clock::time_point now) const
+	{
+		auto elapsed = std::clamp<Clock::duration>(now - m_timestamp, Clock::duration::zero(), m_maxExtrapolation);
+
+		return m_value + m_slope * std::chrono::duration<float>(elapsed).count();
+	}
+
+	bool valid() const	{ return m_valid; }
+
+private:
+	const Clock::duration	m_maxExtrapolation;
+
+	Clock::time_point		m_timestamp;
+	float					m_value = 0.0f;
+	float					m_slope = 0.0f;
+	bool					m_valid = false;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * Time source for the display-side telemetry path.
+ *
+ * Live controllers use the steady clock; replays substitute a VirtualClock
+ * so a recorded session can run faster or slower than real time.
+ */
+class TelemetryClock
+{
+public:
+	using time_point = std::chrono::steady_clock::time_point;
+
+	virtual ~TelemetryClock() = default;
+
+	virtual time_point now() const = 0;
+
+	static const TelemetryClock& steady();
+};
+
+class SteadyTelemetryClock : public TelemetryClock
+{
+public:
+	time_point now() const override		{ return std::chrono::steady_clock::now(); }
+};
+
+class VirtualClock : public TelemetryClock
+{
+public:
+	time_point now() const override		{ return m_now; }
+
+	void set(time_point now)				{ m_now = now; }
+	void advance(std::chrono::nanoseconds delta)	{ m_now += delta; }
+
+private:
+	time_point m_now;
+};
+
+inline const TelemetryClock& TelemetryClock::steady()
+{
+	static const SteadyTelemetryClock clock;
+	return clock;
+}
@@ -0,0 +1,211 @@
+#include "ArcGauge.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Anti-aliased edges reach a pixel or so past the geometry
+	constexpr lv_coord_t kAntiAliasPad = 2;
+
+	constexpr lv_coord_t kTickLength = 8;
+	constexpr lv_coord_t kTickGap = 4;
+	constexpr lv_coord_t kNeedleWidth = 3;
+	constexpr lv_coord_t kHubRadius = 6;
+
+	lv_point_t pointAt(lv_coord_t cx, lv_coord_t cy, float radius, float degrees)
+	{
+		auto radians = degrees * static_cast<float>(M_PI) / 180.0f;
+
+		return { static_cast<lv_coord_t>(std::lround(cx + radius * std::cos(radians))),
+				 static_cast<lv_coord_t>(std::lround(cy + radius * std::sin(radians))) };
+	}
+
+	void include(lv_area_t& area, const lv_point_t& point)
+	{
+		area.x1 = std::min(area.x1, point.x);
+		area.y1 = std::min(area.y1, point.y);
+		area.x2 = std::max(area.x2, point.x);
+		area.y2 = std::max(area.y2, point.y);
+	}
+
+	void pad(lv_area_t& area, lv_coord_t amount)
+	{
+		area.x1 -= amount;
+		area.y1 -= amount;
+		area.x2 += amount;
+		area.y2 += amount;
+	}
+
+	// Bounding box of the ring sector between two angles (from <= to, degrees, may pass 360)
+	lv_area_t sectorArea(lv_coord_t cx, lv_coord_t cy, lv_coord_t outer, lv_coord_t inner, int from, int to)
+	{
+		auto start = pointAt(cx, cy, outer, from);
+		lv_area_t area = { start.x, start.y, start.x, start.y };
+
+		include(area, pointAt(cx, cy, outer, to));
+		include(area, pointAt(cx, cy, inner, from));
+		include(area, pointAt(cx, cy, inner, to));
+
+		// The outer edge bulges furthest where the sector crosses an axis
+		for (auto axis = (from / 90 + 1) * 90; axis < to; axis += 90)
+			include(area, pointAt(cx, cy, outer, axis));
+
+		return area;
+	}
+}
+
+ArcGauge::ArcGauge(lv_obj_t* parent, const Config& config)
+	: m_config(config)
+	, m_trackWidth(std::max<lv_coord_t>(config.size / 12, 4))
+	, m_radius(config.size / 2 - kAntiAliasPad)
+{
+	m_obj = lv_obj_create(parent);
+	lv_obj_remove_style_all(m_obj);
+	lv_obj_set_size(m_obj, config.size, config.size);
+	lv_obj_clear_flag(m_obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+	m_layer = std::make_unique<lv_color_t[]>(static_cast<size_t>(config.size) * config.size);
+
+	m_canvas = lv_canvas_create(m_obj);
+	lv_canvas_set_buffer(m_canvas, m_layer.get(), config.size, config.size, LV_IMG_CF_TRUE_COLOR);
+
+	m_indicatorColor = lv_theme_get_color_primary(m_obj);
+	m_angle = angleFor(config.min);
+
+	renderStatic();
+
+	lv_obj_add_event_cb(m_obj, &ArcGauge::drawCb, LV_EVENT_DRAW_POST, this);
+}
+
+ArcGauge::~ArcGauge()
+{
+	lv_obj_del(m_obj);
+}
+
+void ArcGauge::setValue(float value)
+{
+	auto angle = angleFor(value);
+	if (angle == m_angle)
+		return;
+
+	if (m_config.style == Style::Arc)
+	{
+		invalidateSweep(std::min(angle, m_angle), std::max(angle, m_angle));
+	}
+	else
+	{
+		invalidateNeedle(m_angle);
+		invalidateNeedle(angle);
+	}
+
+	m_angle = angle;
+}
+
+void ArcGauge::drawCb(lv_event_t* event)
+{
+	auto gauge = static_cast<ArcGauge*>(lv_event_get_user_data(event));
+	gauge->draw(lv_event_get_draw_ctx(event));
+}
+
+void ArcGauge::renderStatic()
+{
+	auto center = m_config.size / 2;
+
+	// Opaque on the parent's background, so the layer is a straight copy when drawn
+	lv_canvas_fill_bg(m_canvas, lv_obj_get_style_bg_color(lv_obj_get_parent(m_obj), LV_PART_MAIN), LV_OPA_COVER);
+
+	lv_draw_arc_dsc_t arcDsc;
+	lv_draw_arc_dsc_init(&arcDsc);
+	arcDsc.color = lv_palette_lighten(LV_PALETTE_GREY, 3);
+	arcDsc.width = m_trackWidth;
+	lv_canvas_draw_arc(m_canvas, center, center, m_radius, m_config.startAngle % 360, (m_config.startAngle + m_config.sweep) % 360, &arcDsc);
+
+	lv_draw_line_dsc_t lineDsc;
+	lv_draw_line_dsc_init(&lineDsc);
+	lineDsc.color = lv_palette_main(LV_PALETTE_GREY);
+	lineDsc.width = 2;
+
+	auto tickOuter = m_radius - m_trackWidth - kTickGap;
+	for (uint8_t i = 0; i <= m_config.ticks; ++i)
+	{
+		auto angle = m_config.startAngle + static_cast<float>(m_config.sweep) * i / std::max<uint8_t>(m_config.ticks, 1);
+		lv_point_t points[] = { pointAt(center, center, tickOuter, angle), pointAt(center, center, tickOuter - kTickLength, angle) };
+		lv_canvas_draw_line(m_canvas, points, 2, &lineDsc);
+	}
+
+	if (m_config.style == Style::Needle)
+	{
+		lv_draw_rect_dsc_t hubDsc;
+		lv_draw_rect_dsc_init(&hubDsc);
+		hubDsc.bg_color = lineDsc.color;
+		hubDsc.radius = LV_RADIUS_CIRCLE;
+		lv_canvas_draw_rect(m_canvas, center - kHubRadius, center - kHubRadius, kHubRadius * 2, kHubRadius * 2, &hubDsc);
+	}
+}
+
+void ArcGauge::draw(lv_draw_ctx_t* drawCtx)
+{
+	lv_area_t coords;
+	lv_obj_get_coords(m_obj, &coords);
+
+	lv_point_t center = { static_cast<lv_coord_t>(coords.x1 + m_config.size / 2), static_cast<lv_coord_t>(coords.y1 + m_config.size / 2) };
+
+	if (m_config.style == Style::Arc)
+	{
+		if (m_angle == m_config.startAngle)
+			return;
+
+		lv_draw_arc_dsc_t arcDsc;
+		lv_draw_arc_dsc_init(&arcDsc);
+		arcDsc.color = m_indicatorColor;
+		arcDsc.width = m_trackWidth;
+		lv_draw_arc(drawCtx, &arcDsc, &center, m_radius, m_config.startAngle % 360, m_angle % 360);
+	}
+	else
+	{
+		lv_draw_line_dsc_t lineDsc;
+		lv_draw_line_dsc_init(&lineDsc);
+		lineDsc.color = m_indicatorColor;
+		lineDsc.width = kNeedleWidth;
+		lineDsc.round_end = 1;
+
+		auto tip = pointAt(center.x, center.y, m_radius - m_trackWidth - kTickGap, m_angle);
+		lv_draw_line(drawCtx, &lineDsc, &center, &tip);
+	}
+}
+
+uint16_t ArcGauge::angleFor(float value) const
+{
+	auto range = m_config.max - m_config.min;
+	auto fraction = range > 0.0f ? std::clamp((value - m_config.min) / range, 0.0f, 1.0f) : 0.0f;
+
+	// Unwrapped (may exceed 360) so that ranges compare and sweep simply
+	return m_config.startAngle + static_cast<uint16_t>(std::lround(fraction * m_config.sweep));
+}
+
+void ArcGauge::invalidateSweep(uint16_t from, uint16_t to)
+{
+	lv_area_t coords;
+	lv_obj_get_coords(m_obj, &coords);
+
+	auto area = sectorArea(coords.x1 + m_config.size / 2, coords.y1 + m_config.size / 2, m_radius, m_radius - m_trackWidth, from, to);
+	pad(area, kAntiAliasPad);
+
+	lv_obj_invalidate_area(m_obj, &area);
+}
+
+void ArcGauge::invalidateNeedle(uint16_t angle)
+{
+	lv_area_t coords;
+	lv_obj_get_coords(m_obj, &coords);
+
+	lv_coord_t cx = coords.x1 + m_config.size / 2;
+	lv_coord_t cy = coords.y1 + m_config.size / 2;
+
+	lv_area_t area = { cx, cy, cx, cy };
+	include(area, pointAt(cx, cy, m_radius - m_trackWidth - kTickGap, angle));
+	pad(area, kNeedleWidth / 2 + kAntiAliasPad);
+
+	lv_obj_invalidate_area(m_obj, &area);
+}
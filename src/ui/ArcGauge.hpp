@@ -0,0 +1,72 @@
+#pragma once
+
+#include "lvgl.h"
+
+#include <memory>
+
+/**
+ * Round gauge (arc or needle) that redraws only what a value change
+ * touches.
+ *
+ * The track and tick marks never change, so they are rendered once into a
+ * canvas on the parent's background colour and from then on cost a plain
+ * image copy. A value change invalidates only the annular sector swept
+ * between the old and new value (arc style) or the boxes around the old
+ * and new needle (needle style), so LVGL blits that part of the cached
+ * layer and anti-aliases just the delta of the indicator instead of the
+ * whole gauge.
+ *
+ * Values are resolved to whole degrees, as LVGL draws arcs; changes
+ * smaller than that do not redraw at all.
+ */
+class ArcGauge
+{
+public:
+	enum class Style
+	{
+		Arc,
+		Needle,
+	};
+
+	struct Config
+	{
+		float		min			= 0.0f;
+		float		max			= 100.0f;
+		Style		style		= Style::Arc;
+		lv_coord_t	size		= 120;
+		uint16_t	startAngle	= 135;		// degrees clockwise from 3 o'clock
+		uint16_t	sweep		= 270;
+		uint8_t		ticks		= 10;		// intervals between tick marks
+	};
+
+	ArcGauge(lv_obj_t* parent, const Config& config);
+	~ArcGauge();
+
+	ArcGauge(const ArcGauge&) = delete;
+	ArcGauge& operator=(const ArcGauge&) = delete;
+
+	lv_obj_t* obj() const	{ return m_obj; }
+
+	void setValue(float value);
+
+private:
+	static void drawCb(lv_event_t* event);
+
+	void renderStatic();
+	void draw(lv_draw_ctx_t* drawCtx);
+
+	uint16_t angleFor(float value) const;
+	void invalidateSweep(uint16_t from, uint16_t to);
+	void invalidateNeedle(uint16_t angle);
+
+	const Config					m_config;
+	const lv_coord_t				m_trackWidth;
+	const lv_coord_t				m_radius;
+
+	lv_obj_t*						m_obj;
+	lv_obj_t*						m_canvas;
+	std::unique_ptr<lv_color_t[]>	m_layer;
+
+	lv_color_t						m_indicatorColor;
+	uint16_t						m_angle;
+};
@@ -0,0 +1,74 @@
+#include "HealthAlertBanner.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+HealthAlertBanner::HealthAlertBanner()
+{
+	m_banner = lv_obj_create(lv_layer_top());
+	lv_obj_set_size(m_banner, LV_PCT(100), 40);
+	lv_obj_align(m_banner, LV_ALIGN_BOTTOM_MID, 0, 0);
+	lv_obj_clear_flag(m_banner, LV_OBJ_FLAG_SCROLLABLE);
+	lv_obj_add_flag(m_banner, LV_OBJ_FLAG_HIDDEN);
+
+	m_label = lv_label_create(m_banner);
+	lv_obj_center(m_label);
+}
+
+HealthAlertBanner::~HealthAlertBanner()
+{
+	lv_obj_del(m_banner);
+}
+
+void HealthAlertBanner::onHeapTrendUpdated(const std::string& device, const HeapTrend& trend)
+{
+	if (trend.alert == HeapAlert::None)
+		m_alerts.erase(device);
+	else
+		m_alerts[device] = trend;
+
+	update();
+}
+
+void HealthAlertBanner::update()
+{
+	// Toggling the flag invalidates the banner even when it doesn't change
+	auto hidden = lv_obj_has_flag(m_banner, LV_OBJ_FLAG_HIDDEN);
+
+	if (m_alerts.empty())
+	{
+		if (! hidden)
+			lv_obj_add_flag(m_banner, LV_OBJ_FLAG_HIDDEN);
+
+		return;
+	}
+
+	// Show the most severe alert
+	auto worst = m_alerts.begin();
+	for (auto it = m_alerts.begin(); it != m_alerts.end(); ++it)
+	{
+		if (it->second.alert > worst->second.alert)
+			worst = it;
+	}
+
+	auto& [device, trend] = *worst;
+	auto critical = trend.alert == HeapAlert::Critical;
+
+	auto color = lv_palette_main(critical ? LV_PALETTE_RED : LV_PALETTE_AMBER);
+	if (lv_obj_get_style_bg_color(m_banner, 0).full != color.full)
+		lv_obj_set_style_bg_color(m_banner, color, 0);
+
+	char text[128];
+
+	if (trend.hoursToExhaustion >= 0.0f)
+		snprintf(text, sizeof(text), "%s: heap %d KB, exhausted in ~%.1f h", device.c_str(), trend.freeHeap / 1024, trend.hoursToExhaustion);
+	else
+		snprintf(text, sizeof(text), "%s: heap low (%d KB)", device.c_str(), trend.freeHeap / 1024);
+
+	// Trend updates arrive with every sys/info poll; most leave the text as it was
+	if (strcmp(lv_label_get_text(m_label), text) != 0)
+		lv_label_set_text(m_label, text);
+
+	if (hidden)
+		lv_obj_clear_flag(m_banner, LV_OBJ_FLAG_HIDDEN);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "HealthMonitor.hpp"
+
+#include "lvgl.h"
+
+#include <map>
+
+/**
+ * Warning strip along the bottom of LVGL's top layer while any device
+ * reports a heap alert. Follows every trend update so the projection stays
+ * current, but only redraws when the text or severity changes.
+ */
+class HealthAlertBanner : public DeviceHealthDelegate
+{
+public:
+	HealthAlertBanner();
+	~HealthAlertBanner();
+
+	// DeviceHealthDelegate i/f
+	void onHeapTrendUpdated(const std::string& device, const HeapTrend& trend) override;
+
+private:
+	void update();
+
+	lv_obj_t*							m_banner;
+	lv_obj_t*							m_label;
+
+	std::map<std::string, HeapTrend>	m_alerts;
+};
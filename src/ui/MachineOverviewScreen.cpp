@@ -0,0 +1,190 @@
+#include "MachineOverviewScreen.hpp"
+
+namespace
+{
+	constexpr lv_coord_t kTileWidth = 380;
+	constexpr lv_coord_t kTileHeight = 220;
+
+	// "-12.3 / 123", "12.3", "-1234.5"
+	constexpr size_t kTempChars = 11;
+	constexpr size_t kPressureChars = 4;
+	constexpr size_t kWeightChars = 7;
+
+	constexpr float kGaugeMaxPressure = 12.0f;
+	constexpr lv_coord_t kGaugeSize = 80;
+
+	const char* stateName(BoilerState state)
+	{
+		switch (state)
+		{
+			case BoilerState::Heating:		return "Heating";
+			case BoilerState::Ready:		return "Ready";
+			case BoilerState::Brewing:		return "Brewing";
+			case BoilerState::Inhibited:	return "Inhibited";
+			case BoilerState::Idle:			return "Idle";
+		}
+
+		return "";
+	}
+}
+
+MachineOverviewScreen::MachineOverviewScreen(DeviceRegistry& registry)
+	: m_registry(registry)
+{
+	m_screen = lv_obj_create(nullptr);
+	lv_obj_set_flex_flow(m_screen, LV_FLEX_FLOW_ROW_WRAP);
+	lv_obj_set_style_pad_all(m_screen, 10, 0);
+	lv_obj_set_style_pad_gap(m_screen, 10, 0);
+
+	m_layers = std::make_unique<ScreenLayerCache>(m_screen);
+
+	for (size_t i = 0; i < m_registry.size(); ++i)
+		onMachineAdded(m_registry[i]);
+
+	m_registry.registerDelegate(this);
+}
+
+MachineOverviewScreen::~MachineOverviewScreen()
+{
+	m_registry.deregisterDelegate(this);
+
+	m_layers.reset();
+	m_tiles.clear();
+	lv_obj_del(m_screen);
+}
+
+void MachineOverviewScreen::show()
+{
+	lv_scr_load(m_screen);
+}
+
+void MachineOverviewScreen::onMachineAdded(Machine& machine)
+{
+	m_tiles.emplace_back(std::make_unique<Tile>(m_screen, machine, *m_layers));
+
+	if (machine.boiler)
+		onBoilerConnected(machine);
+
+	if (machine.scales)
+		onScalesConnected(machine);
+}
+
+void MachineOverviewScreen::onBoilerConnected(Machine& machine)
+{
+	if (auto tile = findTile(machine))
+		machine.boiler->registerBoilerTemperatureDelegate(tile);
+}
+
+void MachineOverviewScreen::onScalesConnected(Machine& machine)
+{
+	if (auto tile = findTile(machine))
+		machine.scales->registerWeightDelegate(tile);
+}
+
+MachineOverviewScreen::Tile* MachineOverviewScreen::findTile(Machine& machine)
+{
+	for (auto& tile : m_tiles)
+	{
+		if (&tile->machine() == &machine)
+			return tile.get();
+	}
+
+	return nullptr;
+}
+
+MachineOverviewScreen::Tile::Tile(lv_obj_t* parent, Machine& machine, ScreenLayerCache& layers)
+	: m_machine(machine)
+{
+	m_tile = lv_obj_create(parent);
+	lv_obj_set_size(m_tile, kTileWidth, kTileHeight);
+	lv_obj_set_flex_flow(m_tile, LV_FLEX_FLOW_COLUMN);
+	lv_obj_clear_flag(m_tile, LV_OBJ_FLAG_SCROLLABLE);
+
+	auto name = lv_label_create(m_tile);
+	lv_obj_set_style_text_font(name, &lv_font_montserrat_24, 0);
+	lv_label_set_text(name, machine.config.name.c_str());
+
+	m_state = lv_label_create(m_tile);
+	lv_label_set_text(m_state, "Connecting...");
+
+	m_temp = std::make_unique<NumericReadout>(m_tile, &lv_font_montserrat_36, kTempChars, " °C");
+	m_temp->setText("--");
+
+	m_pressure = std::make_unique<NumericReadout>(m_tile, LV_FONT_DEFAULT, kPressureChars, " bar");
+	m_pressure->setText("--");
+
+	if (! machine.config.scalesHostname.empty())
+	{
+		m_weight = std::make_unique<NumericReadout>(m_tile, LV_FONT_DEFAULT, kWeightChars, " g");
+		m_weight->setText("--");
+	}
+
+	ArcGauge::Config gauge;
+	gauge.max = kGaugeMaxPressure;
+	gauge.size = kGaugeSize;
+	gauge.ticks = 6;
+
+	// In the corner below the temperature, beside the smaller readouts
+	m_pressureGauge = std::make_unique<ArcGauge>(m_tile, gauge);
+	lv_obj_add_flag(m_pressureGauge->obj(), LV_OBJ_FLAG_FLOATING);
+	lv_obj_align(m_pressureGauge->obj(), LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+
+	// The gauge already blits its own cached face
+	layers.addDynamic(m_state);
+	layers.addDynamic(m_temp->obj());
+	layers.addDynamic(m_pressure->obj());
+
+	if (m_weight)
+		layers.addDynamic(m_weight->obj());
+}
+
+MachineOverviewScreen::Tile::~Tile()
+{
+	if (m_machine.boiler)
+		m_machine.boiler->deregisterBoilerTemperatureDelegate(this);
+
+	if (m_machine.scales)
+		m_machine.scales->deregisterWeightDelegate(this);
+
+	// The readouts and gauge delete their own objects, so they go before the tile
+	m_temp.reset();
+	m_pressure.reset();
+	m_weight.reset();
+	m_pressureGauge.reset();
+
+	lv_obj_del(m_tile);
+}
+
+void MachineOverviewScreen::Tile::onBoilerCurrentTempChanged(float temp)
+{
+	m_currentTemp = temp;
+	updateTemp();
+}
+
+void MachineOverviewScreen::Tile::onBoilerTargetTempChanged(float temp)
+{
+	m_targetTemp = temp;
+	updateTemp();
+}
+
+void MachineOverviewScreen::Tile::onBoilerStateChanged(BoilerState state)
+{
+	lv_label_set_text_static(m_state, stateName(state));
+}
+
+void MachineOverviewScreen::Tile::onBoilerPressureChanged(float pressure)
+{
+	m_pressure->setFormat("%.1f", pressure);
+	m_pressureGauge->setValue(pressure);
+}
+
+void MachineOverviewScreen::Tile::onScalesWeightChanged(float weight)
+{
+	if (m_weight)
+		m_weight->setFormat("%.1f", weight);
+}
+
+void MachineOverviewScreen::Tile::updateTemp()
+{
+	m_temp->setFormat("%.1f / %.0f", m_currentTemp, m_targetTemp);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ArcGauge.hpp"
+#include "DeviceRegistry.hpp"
+#include "NumericReadout.hpp"
+#include "ScreenLayerCache.hpp"
+
+#include "lvgl.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Dashboard with one tile per registered machine showing boiler state,
+ * temperature, pressure and weight. Tiles wrap in a flex grid so the same
+ * screen serves one machine or a whole café.
+ */
+class MachineOverviewScreen : public DeviceRegistryDelegate
+{
+public:
+	explicit MachineOverviewScreen(DeviceRegistry& registry);
+	~MachineOverviewScreen();
+
+	void show();
+
+	// DeviceRegistryDelegate i/f
+	void onMachineAdded(Machine& machine) override;
+	void onBoilerConnected(Machine& machine) override;
+	void onScalesConnected(Machine& machine) override;
+
+private:
+	class Tile : public BoilerTemperatureDelegate, public ScalesWeightDelegate
+	{
+	public:
+		Tile(lv_obj_t* parent, Machine& machine, ScreenLayerCache& layers);
+		~Tile();
+
+		Machine&	machine()	{ return m_machine; }
+
+		// BoilerTemperatureDelegate i/f
+		void onBoilerCurrentTempChanged(float temp) override;
+		void onBoilerTargetTempChanged(float temp) override;
+		void onBoilerStateChanged(BoilerState state) override;
+		void onBoilerPressureChanged(float pressure) override;
+
+		// ScalesWeightDelegate i/f
+		void onScalesWeightChanged(float weight) override;
+
+	private:
+		void updateTemp();
+
+		Machine&	m_machine;
+
+		lv_obj_t*	m_tile;
+		lv_obj_t*	m_state;
+
+		std::unique_ptr<NumericReadout>	m_temp;
+		std::unique_ptr<NumericReadout>	m_pressure;
+		std::unique_ptr<NumericReadout>	m_weight;
+		std::unique_ptr<ArcGauge>		m_pressureGauge;
+
+		float		m_currentTemp = 0.0f;
+		float		m_targetTemp = 0.0f;
+	};
+
+	Tile* findTile(Machine& machine);
+
+	DeviceRegistry&						m_registry;
+
+	lv_obj_t*							m_screen;
+	std::unique_ptr<ScreenLayerCache>	m_layers;
+	std::vector<std::unique_ptr<Tile>>	m_tiles;
+};
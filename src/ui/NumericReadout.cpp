@@ -0,0 +1,276 @@
+#include "NumericReadout.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr const char* kCharset = "0123456789.,-+/:% ";
+
+	bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+}
+
+struct NumericReadout::Atlas
+{
+	struct Glyph
+	{
+		lv_img_dsc_t	img = {};
+		bool			blank = true;
+	};
+
+	const Glyph& glyph(char c) const
+	{
+		// Index 0 is never filled, so anything outside the table draws nothing
+		auto index = static_cast<unsigned char>(c);
+		return index < glyphs.size() ? glyphs[index] : glyphs[0];
+	}
+
+	const lv_font_t*			font;
+	lv_color_t					color;
+	lv_coord_t					height;
+	std::array<Glyph, 128>		glyphs;
+	std::vector<uint8_t>		pixels;
+
+	// Shared by every readout with the same font and colour; never freed
+	static const Atlas* get(const lv_font_t* font, lv_color_t color)
+	{
+		static std::vector<std::unique_ptr<Atlas>> s_atlases;
+
+		for (auto& atlas : s_atlases)
+		{
+			if (atlas->font == font && atlas->color.full == color.full)
+				return atlas.get();
+		}
+
+		s_atlases.emplace_back(std::make_unique<Atlas>(font, color));
+		return s_atlases.back().get();
+	}
+
+	Atlas(const lv_font_t* font, lv_color_t color)
+		: font(font)
+		, color(color)
+		, height(lv_font_get_line_height(font))
+	{
+		std::array<lv_font_glyph_dsc_t, 128> dscs = {};
+
+		// All digits share the widest digit's advance so a changing digit never moves its neighbours
+		lv_coord_t digitWidth = 0;
+		for (uint8_t c = '0'; c <= '9'; ++c)
+		{
+			lv_font_get_glyph_dsc(font, &dscs[c], c, 0);
+			digitWidth = LV_MAX(digitWidth, static_cast<lv_coord_t>(dscs[c].adv_w));
+		}
+
+		size_t total = 0;
+		for (auto c = kCharset; *c; ++c)
+		{
+			auto& dsc = dscs[static_cast<uint8_t>(*c)];
+			if (! isDigit(*c))
+				lv_font_get_glyph_dsc(font, &dsc, *c, 0);
+
+			auto width = isDigit(*c) ? digitWidth : static_cast<lv_coord_t>(dsc.adv_w);
+			total += static_cast<size_t>(width) * height * LV_IMG_PX_SIZE_ALPHA_BYTE;
+		}
+
+		pixels.resize(total);
+
+		size_t offset = 0;
+		for (auto c = kCharset; *c; ++c)
+		{
+			auto& dsc = dscs[static_cast<uint8_t>(*c)];
+			auto width = isDigit(*c) ? digitWidth : static_cast<lv_coord_t>(dsc.adv_w);
+			auto data = pixels.data() + offset;
+			offset += static_cast<size_t>(width) * height * LV_IMG_PX_SIZE_ALPHA_BYTE;
+
+			auto& glyph = glyphs[static_cast<uint8_t>(*c)];
+			glyph.img.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+			glyph.img.header.w = width;
+			glyph.img.header.h = height;
+			glyph.img.data_size = static_cast<uint32_t>(width) * height * LV_IMG_PX_SIZE_ALPHA_BYTE;
+			glyph.img.data = data;
+
+			for (int i = 0; i < width * height; ++i)
+			{
+				memcpy(data + i * LV_IMG_PX_SIZE_ALPHA_BYTE, &color, sizeof(lv_color_t));
+				data[i * LV_IMG_PX_SIZE_ALPHA_BYTE + LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = 0;
+			}
+
+			if (dsc.box_w == 0 || dsc.box_h == 0 || dsc.bpp == 0)
+				continue;
+
+			auto bitmap = lv_font_get_glyph_bitmap(font, *c);
+			if (! bitmap)
+				continue;
+
+			// Same placement as lv_draw_letter, centred in a widened digit cell
+			auto left = dsc.ofs_x + (width - static_cast<lv_coord_t>(dsc.adv_w)) / 2;
+			auto top = (font->line_height - font->base_line) - dsc.box_h - dsc.ofs_y;
+			auto maxValue = (1u << dsc.bpp) - 1;
+
+			// Font bitmaps are packed MSB first with no padding between rows
+			size_t bit = 0;
+			for (lv_coord_t y = 0; y < dsc.box_h; ++y)
+			{
+				for (lv_coord_t x = 0; x < dsc.box_w; ++x, bit += dsc.bpp)
+				{
+					auto shift = bit % 8;
+					auto window = static_cast<uint32_t>(bitmap[bit / 8]) << 8;
+					if (shift + dsc.bpp > 8)
+						window |= bitmap[bit / 8 + 1];
+
+					auto value = (window >> (16 - dsc.bpp - shift)) & maxValue;
+					auto px = left + x;
+					auto py = top + y;
+
+					if (value == 0 || px < 0 || px >= width || py < 0 || py >= height)
+						continue;
+
+					data[(py * width + px) * LV_IMG_PX_SIZE_ALPHA_BYTE + LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = value * 255 / maxValue;
+					glyph.blank = false;
+				}
+			}
+		}
+	}
+};
+
+NumericReadout::NumericReadout(lv_obj_t* parent, const lv_font_t* font, size_t maxChars, const char* suffix)
+	: m_suffix(suffix)
+{
+	m_obj = lv_obj_create(parent);
+	lv_obj_remove_style_all(m_obj);
+	lv_obj_clear_flag(m_obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+	// Text colour is inherited from the parent's style
+	m_atlas = Atlas::get(font, lv_obj_get_style_text_color(m_obj, LV_PART_MAIN));
+	m_suffixWidth = lv_txt_get_width(m_suffix.c_str(), m_suffix.size(), font, 0, LV_TEXT_FLAG_NONE);
+
+	auto digitWidth = static_cast<lv_coord_t>(m_atlas->glyph('0').img.header.w);
+	lv_obj_set_size(m_obj, digitWidth * static_cast<lv_coord_t>(maxChars) + m_suffixWidth, m_atlas->height);
+
+	lv_obj_add_event_cb(m_obj, &NumericReadout::drawCb, LV_EVENT_DRAW_MAIN, this);
+}
+
+NumericReadout::~NumericReadout()
+{
+	lv_obj_del(m_obj);
+}
+
+void NumericReadout::setFormat(const char* format, ...)
+{
+	char text[kCapacity];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	setText(text);
+}
+
+void NumericReadout::setText(const char* text)
+{
+	auto length = strnlen(text, kCapacity - 1);
+	auto current = strlen(m_text.data());
+
+	if (length == current && strncmp(text, m_text.data(), length) == 0)
+		return;
+
+	// Cells only stay put if the length and the non-digit characters are unchanged
+	auto sameLayout = length == current;
+	for (size_t i = 0; sameLayout && i < length; ++i)
+		sameLayout = text[i] == m_text[i] || (isDigit(text[i]) && isDigit(m_text[i]));
+
+	if (sameLayout)
+	{
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (text[i] == m_text[i])
+				continue;
+
+			auto area = cellArea(m_text.data(), i);
+			lv_obj_invalidate_area(m_obj, &area);
+		}
+	}
+	else
+	{
+		lv_obj_invalidate(m_obj);
+	}
+
+	memcpy(m_text.data(), text, length);
+	m_text[length] = '\0';
+}
+
+void NumericReadout::drawCb(lv_event_t* event)
+{
+	auto readout = static_cast<NumericReadout*>(lv_event_get_user_data(event));
+	readout->draw(lv_event_get_draw_ctx(event));
+}
+
+void NumericReadout::draw(lv_draw_ctx_t* drawCtx)
+{
+	lv_draw_img_dsc_t imgDsc;
+	lv_draw_img_dsc_init(&imgDsc);
+	imgDsc.opa = lv_obj_get_style_opa(m_obj, LV_PART_MAIN);
+
+	for (size_t i = 0; m_text[i]; ++i)
+	{
+		auto& glyph = m_atlas->glyph(m_text[i]);
+		if (glyph.blank)
+			continue;
+
+		auto area = cellArea(m_text.data(), i);
+		if (_lv_area_is_on(&area, drawCtx->clip_area))
+			lv_draw_img(drawCtx, &imgDsc, &area, &glyph.img);
+	}
+
+	if (m_suffix.empty())
+		return;
+
+	lv_area_t area;
+	lv_obj_get_coords(m_obj, &area);
+	area.x1 = area.x2 - m_suffixWidth + 1;
+
+	if (! _lv_area_is_on(&area, drawCtx->clip_area))
+		return;
+
+	lv_draw_label_dsc_t labelDsc;
+	lv_draw_label_dsc_init(&labelDsc);
+	labelDsc.font = m_atlas->font;
+	labelDsc.color = m_atlas->color;
+	labelDsc.opa = imgDsc.opa;
+
+	lv_draw_label(drawCtx, &labelDsc, &area, m_suffix.c_str(), nullptr);
+}
+
+lv_coord_t NumericReadout::textWidth(const char* text) const
+{
+	lv_coord_t width = 0;
+	for (; *text; ++text)
+		width += m_atlas->glyph(*text).img.header.w;
+
+	return width;
+}
+
+lv_area_t NumericReadout::cellArea(const char* text, size_t index) const
+{
+	lv_area_t coords;
+	lv_obj_get_coords(m_obj, &coords);
+
+	// Right aligned against the suffix
+	lv_area_t area;
+	area.x1 = coords.x2 - m_suffixWidth + 1 - textWidth(text);
+	for (size_t i = 0; i < index; ++i)
+		area.x1 += m_atlas->glyph(text[i]).img.header.w;
+
+	area.x2 = area.x1 + m_atlas->glyph(text[index]).img.header.w - 1;
+	area.y1 = coords.y1;
+	area.y2 = coords.y1 + m_atlas->height - 1;
+
+	return area;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "lvgl.h"
+
+#include <array>
+#include <string>
+
+/**
+ * Number display for readouts that change several times a second
+ * (temperature, pressure, weight, shot time).
+ *
+ * Unlike a label, an update does not touch the LVGL heap or shape glyphs:
+ * the text is formatted into fixed storage, and each character is drawn
+ * as a small blit from a digit atlas pre-rendered once per font and colour.
+ * Digits sit in equal-width cells, so when only digits change only their
+ * cells are invalidated; the rest of the readout and its unit suffix are
+ * not redrawn.
+ *
+ * Characters outside "0123456789.,-+/:% " are not drawn; put units in the
+ * suffix, which is drawn as ordinary text. Text is right aligned in a box
+ * sized for maxChars digits plus the suffix.
+ */
+class NumericReadout
+{
+public:
+	static constexpr size_t kCapacity = 24;
+
+	NumericReadout(lv_obj_t* parent, const lv_font_t* font, size_t maxChars, const char* suffix = "");
+	~NumericReadout();
+
+	NumericReadout(const NumericReadout&) = delete;
+	NumericReadout& operator=(const NumericReadout&) = delete;
+
+	lv_obj_t* obj() const	{ return m_obj; }
+
+	void setText(const char* text);
+	void setFormat(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+	struct Atlas;
+
+	static void drawCb(lv_event_t* event);
+
+	void draw(lv_draw_ctx_t* drawCtx);
+	lv_coord_t textWidth(const char* text) const;
+	lv_area_t cellArea(const char* text, size_t index) const;
+
+	lv_obj_t*							m_obj;
+	const Atlas*						m_atlas;
+
+	std::string							m_suffix;
+	lv_coord_t							m_suffixWidth;
+
+	std::array<char, kCapacity>			m_text = {};
+};
@@ -0,0 +1,232 @@
+#include "ScreenLayerCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+
+namespace
+{
+	constexpr uint32_t kRebuildDelay = 200;		// ms
+}
+
+ScreenLayerCache::ScreenLayerCache(lv_obj_t* screen)
+	: m_screen(screen)
+{
+	watch(m_screen);
+
+	m_rebuildTimer = lv_timer_create(&ScreenLayerCache::rebuildTimerCb, kRebuildDelay, this);
+	lv_timer_pause(m_rebuildTimer);
+}
+
+ScreenLayerCache::~ScreenLayerCache()
+{
+	lv_timer_del(m_rebuildTimer);
+
+	while (! m_backdrops.empty())
+		removeDynamic(m_backdrops.back()->widget);
+
+	if (m_screen)
+		unwatch(m_screen);
+}
+
+void ScreenLayerCache::addDynamic(lv_obj_t* widget)
+{
+	auto parent = lv_obj_get_parent(widget);
+
+	if (! watchesParent(parent))
+		watch(parent);
+
+	m_backdrops.push_back(std::make_unique<Backdrop>());
+	m_backdrops.back()->widget = widget;
+	watch(widget);
+
+	invalidate();
+}
+
+void ScreenLayerCache::removeDynamic(lv_obj_t* widget)
+{
+	auto it = std::find_if(m_backdrops.begin(), m_backdrops.end(), [widget](const auto& backdrop) { return backdrop->widget == widget; });
+	if (it == m_backdrops.end())
+		return;
+
+	unwatch(widget);
+	clearBackdrop(**it);
+	m_backdrops.erase(it);
+
+	auto parent = lv_obj_get_parent(widget);
+	if (! watchesParent(parent))
+		unwatch(parent);
+}
+
+void ScreenLayerCache::invalidate()
+{
+	// Restarted on every change so a burst of layout work leads to one rebuild
+	lv_timer_reset(m_rebuildTimer);
+	lv_timer_resume(m_rebuildTimer);
+}
+
+void ScreenLayerCache::eventCb(lv_event_t* event)
+{
+	auto cache = static_cast<ScreenLayerCache*>(lv_event_get_user_data(event));
+
+	auto target = lv_event_get_target(event);
+
+	switch (lv_event_get_code(event))
+	{
+	case LV_EVENT_DELETE:
+		if (target == cache->m_screen)
+			cache->m_screen = nullptr;
+		else
+			cache->removeDynamic(target);
+		break;
+
+	case LV_EVENT_STYLE_CHANGED:
+		// Theme changes restyle the screen; the widgets' own styles don't affect what's under them
+		if (target == cache->m_screen)
+			cache->invalidate();
+		break;
+
+	case LV_EVENT_SIZE_CHANGED:
+		// A stale backdrop would no longer line up, so show the widget transparent until the rebuild
+		for (auto& backdrop : cache->m_backdrops)
+		{
+			if (backdrop->widget == target)
+				cache->clearBackdrop(*backdrop);
+		}
+
+		cache->invalidate();
+		break;
+
+	case LV_EVENT_LAYOUT_CHANGED:
+		cache->invalidate();
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ScreenLayerCache::rebuildTimerCb(lv_timer_t* timer)
+{
+	auto cache = static_cast<ScreenLayerCache*>(timer->user_data);
+
+	lv_timer_pause(timer);
+	cache->rebuild();
+}
+
+void ScreenLayerCache::rebuild()
+{
+	if (! m_screen || m_backdrops.empty())
+		return;
+
+	lv_obj_update_layout(m_screen);
+
+	// Render without the dynamic widgets; transparent rather than hidden so the layout stays put
+	std::vector<std::optional<lv_style_value_t>> opacities;
+	for (auto& backdrop : m_backdrops)
+	{
+		lv_style_value_t value;
+		auto local = lv_obj_get_local_style_prop(backdrop->widget, LV_STYLE_OPA, &value, LV_PART_MAIN) == LV_RES_OK;
+
+		opacities.push_back(local ? std::optional(value) : std::nullopt);
+		lv_obj_set_style_opa(backdrop->widget, LV_OPA_TRANSP, LV_PART_MAIN);
+	}
+
+	auto size = lv_snapshot_buf_size_needed(m_screen, LV_IMG_CF_TRUE_COLOR);
+	auto snapshot = std::make_unique<uint8_t[]>(size);
+	lv_img_dsc_t snapshotDsc;
+
+	auto result = lv_snapshot_take_to_buf(m_screen, LV_IMG_CF_TRUE_COLOR, &snapshotDsc, snapshot.get(), size);
+
+	for (size_t i = 0; i < m_backdrops.size(); ++i)
+	{
+		if (opacities[i])
+			lv_obj_set_local_style_prop(m_backdrops[i]->widget, LV_STYLE_OPA, *opacities[i], LV_PART_MAIN);
+		else
+			lv_obj_remove_local_style_prop(m_backdrops[i]->widget, LV_STYLE_OPA, LV_PART_MAIN);
+	}
+
+	if (result != LV_RES_OK)
+	{
+		printf("ScreenLayerCache: Unable to snapshot the screen\n");
+		return;
+	}
+
+	// The snapshot is centred on the screen, grown by its extended draw area
+	lv_area_t screenCoords;
+	lv_obj_get_coords(m_screen, &screenCoords);
+	auto originX = screenCoords.x1 - (static_cast<lv_coord_t>(snapshotDsc.header.w) - lv_area_get_width(&screenCoords)) / 2;
+	auto originY = screenCoords.y1 - (static_cast<lv_coord_t>(snapshotDsc.header.h) - lv_area_get_height(&screenCoords)) / 2;
+
+	auto source = reinterpret_cast<const lv_color_t*>(snapshot.get());
+	auto stride = static_cast<size_t>(snapshotDsc.header.w);
+
+	for (auto& backdrop : m_backdrops)
+	{
+		lv_area_t area;
+		lv_obj_get_coords(backdrop->widget, &area);
+
+		auto width = lv_area_get_width(&area);
+		auto height = lv_area_get_height(&area);
+
+		if (width <= 0 || height <= 0
+			|| area.x1 < originX || area.y1 < originY
+			|| area.x2 - originX >= static_cast<lv_coord_t>(snapshotDsc.header.w)
+			|| area.y2 - originY >= static_cast<lv_coord_t>(snapshotDsc.header.h))
+			continue;
+
+		auto pixels = std::make_unique<lv_color_t[]>(static_cast<size_t>(width) * height);
+		for (lv_coord_t y = 0; y < height; ++y)
+		{
+			auto row = source + static_cast<size_t>(area.y1 - originY + y) * stride + (area.x1 - originX);
+			memcpy(pixels.get() + static_cast<size_t>(y) * width, row, width * sizeof(lv_color_t));
+		}
+
+		if (backdrop->pixels)
+			lv_img_cache_invalidate_src(&backdrop->img);
+
+		backdrop->pixels = std::move(pixels);
+		backdrop->img.header.cf = LV_IMG_CF_TRUE_COLOR;
+		backdrop->img.header.w = width;
+		backdrop->img.header.h = height;
+		backdrop->img.data_size = static_cast<uint32_t>(width) * height * sizeof(lv_color_t);
+		backdrop->img.data = reinterpret_cast<const uint8_t*>(backdrop->pixels.get());
+
+		// Opaque, so LVGL starts redrawing from the widget instead of the screen
+		lv_obj_set_style_bg_img_src(backdrop->widget, &backdrop->img, LV_PART_MAIN);
+		lv_obj_set_style_bg_opa(backdrop->widget, LV_OPA_COVER, LV_PART_MAIN);
+	}
+
+	// Changes reported while laying out and restyling above are already reflected here
+	lv_timer_pause(m_rebuildTimer);
+}
+
+void ScreenLayerCache::clearBackdrop(Backdrop& backdrop)
+{
+	if (! backdrop.pixels)
+		return;
+
+	lv_obj_remove_local_style_prop(backdrop.widget, LV_STYLE_BG_IMG_SRC, LV_PART_MAIN);
+	lv_obj_remove_local_style_prop(backdrop.widget, LV_STYLE_BG_OPA, LV_PART_MAIN);
+	lv_img_cache_invalidate_src(&backdrop.img);
+
+	backdrop.pixels.reset();
+}
+
+bool ScreenLayerCache::watchesParent(lv_obj_t* parent) const
+{
+	// The screen is always watched, and siblings share their parent's registration
+	return parent == m_screen || std::any_of(m_backdrops.begin(), m_backdrops.end(),
+		[parent](const auto& backdrop) { return lv_obj_get_parent(backdrop->widget) == parent; });
+}
+
+void ScreenLayerCache::watch(lv_obj_t* obj)
+{
+	lv_obj_add_event_cb(obj, &ScreenLayerCache::eventCb, LV_EVENT_ALL, this);
+}
+
+void ScreenLayerCache::unwatch(lv_obj_t* obj)
+{
+	lv_obj_remove_event_cb_with_user_data(obj, &ScreenLayerCache::eventCb, this);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "lvgl.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Cached composite of a screen's static content, used as the backdrop of
+ * the widgets on it that change often.
+ *
+ * When a transparent widget (a label, a readout) changes, LVGL redraws the
+ * whole stack under it: screen background, panels, borders, shadows,
+ * gradients. LVGL starts redrawing from the topmost object that fully
+ * covers the invalidated area, though, so once a widget is opaque nothing
+ * below it is touched.
+ *
+ * This renders the screen once with its dynamic widgets hidden, crops the
+ * area under each dynamic widget out of the snapshot and sets it as that
+ * widget's opaque background image. Updates then blit the cached backdrop
+ * and draw the widget's own content on it. The snapshot is rebuilt, after
+ * things settle for kRebuildDelay, when the theme or styles change or when
+ * a dynamic widget is resized or laid out again.
+ *
+ * Dynamic widgets must not overlap each other, and static content under
+ * them must not change without invalidate().
+ */
+class ScreenLayerCache
+{
+public:
+	explicit ScreenLayerCache(lv_obj_t* screen);
+	~ScreenLayerCache();
+
+	ScreenLayerCache(const ScreenLayerCache&) = delete;
+	ScreenLayerCache& operator=(const ScreenLayerCache&) = delete;
+
+	// The widget's own background is replaced; it is forgotten automatically when deleted
+	void addDynamic(lv_obj_t* widget);
+	void removeDynamic(lv_obj_t* widget);
+
+	// Schedules a rebuild
+	void invalidate();
+
+private:
+	// Heap allocated: the widget's style points at img, so it must not move
+	struct Backdrop
+	{
+		lv_obj_t*						widget;
+		std::unique_ptr<lv_color_t[]>	pixels;
+		lv_img_dsc_t					img = {};
+	};
+
+	static void eventCb(lv_event_t* event);
+	static void rebuildTimerCb(lv_timer_t* timer);
+
+	void rebuild();
+	void clearBackdrop(Backdrop& backdrop);
+	bool watchesParent(lv_obj_t* parent) const;
+	void watch(lv_obj_t* obj);
+	void unwatch(lv_obj_t* obj);
+
+	lv_obj_t*								m_screen;
+	lv_timer_t*								m_rebuildTimer;
+	std::vector<std::unique_ptr<Backdrop>>	m_backdrops;
+};
@@ -0,0 +1,56 @@
+#include "ShotTimerOverlay.hpp"
+
+namespace
+{
+	constexpr uint32_t kHideDelay = 10000;
+
+	// "999.9"
+	constexpr size_t kMaxChars = 5;
+}
+
+ShotTimerOverlay::ShotTimerOverlay()
+	: m_readout(lv_layer_top(), &lv_font_montserrat_28, kMaxChars, " s")
+{
+	lv_obj_align(m_readout.obj(), LV_ALIGN_TOP_RIGHT, -20, 20);
+	lv_obj_add_flag(m_readout.obj(), LV_OBJ_FLAG_HIDDEN);
+}
+
+ShotTimerOverlay::~ShotTimerOverlay()
+{
+	if (m_hideTimer)
+		lv_timer_del(m_hideTimer);
+}
+
+void ShotTimerOverlay::onShotStarted()
+{
+	if (m_hideTimer)
+	{
+		lv_timer_del(m_hideTimer);
+		m_hideTimer = nullptr;
+	}
+
+	lv_obj_clear_flag(m_readout.obj(), LV_OBJ_FLAG_HIDDEN);
+}
+
+void ShotTimerOverlay::onShotTimerChanged(float seconds)
+{
+	m_readout.setFormat("%.1f", seconds);
+}
+
+void ShotTimerOverlay::onShotStopped(float seconds)
+{
+	m_readout.setFormat("%.1f", seconds);
+
+	m_hideTimer = lv_timer_create(&ShotTimerOverlay::hideTimerCb, kHideDelay, this);
+	lv_timer_set_repeat_count(m_hideTimer, 1);
+}
+
+void ShotTimerOverlay::hideTimerCb(lv_timer_t* timer)
+{
+	auto overlay = static_cast<ShotTimerOverlay*>(timer->user_data);
+
+	lv_obj_add_flag(overlay->m_readout.obj(), LV_OBJ_FLAG_HIDDEN);
+
+	// Repeat count of 1: LVGL deletes the timer after this call
+	overlay->m_hideTimer = nullptr;
+}
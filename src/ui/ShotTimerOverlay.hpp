@@ -0,0 +1,28 @@
+#pragma once
+
+#include "NumericReadout.hpp"
+#include "ShotSession.hpp"
+
+#include "lvgl.h"
+
+/**
+ * Shot timer readout on LVGL's top layer, shown from the start of a shot
+ * until kHideDelay after it stops.
+ */
+class ShotTimerOverlay : public ShotTimerDelegate
+{
+public:
+	ShotTimerOverlay();
+	~ShotTimerOverlay();
+
+	// ShotTimerDelegate i/f
+	void onShotStarted() override;
+	void onShotTimerChanged(float seconds) override;
+	void onShotStopped(float seconds) override;
+
+private:
+	static void hideTimerCb(lv_timer_t* timer);
+
+	NumericReadout	m_readout;
+	lv_timer_t*		m_hideTimer = nullptr;
+};
@@ -0,0 +1,23 @@
+#include "StabilityIndicator.hpp"
+
+StabilityIndicator::StabilityIndicator()
+{
+	m_led = lv_led_create(lv_layer_top());
+	lv_obj_set_size(m_led, 16, 16);
+	lv_obj_align(m_led, LV_ALIGN_TOP_LEFT, 20, 20);
+	lv_led_set_color(m_led, lv_palette_main(LV_PALETTE_GREEN));
+	lv_led_off(m_led);
+}
+
+StabilityIndicator::~StabilityIndicator()
+{
+	lv_obj_del(m_led);
+}
+
+void StabilityIndicator::onThermalStabilityChanged(bool stable)
+{
+	if (stable)
+		lv_led_on(m_led);
+	else
+		lv_led_off(m_led);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "TemperatureStability.hpp"
+
+#include "lvgl.h"
+
+/**
+ * "Thermally stable" indicator on LVGL's top layer. A small dot that turns
+ * green once TemperatureStability reports the boiler has settled.
+ */
+class StabilityIndicator : public TemperatureStabilityDelegate
+{
+public:
+	StabilityIndicator();
+	~StabilityIndicator();
+
+	// TemperatureStabilityDelegate i/f
+	void onThermalStabilityChanged(bool stable) override;
+
+private:
+	lv_obj_t*	m_led;
+};